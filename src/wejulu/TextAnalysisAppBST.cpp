@@ -21,6 +21,83 @@
  * Output - The program outputs to a file named 'output.txt', which starts with the author's ID ("wejulu"), followed by
  * the analysis of each file. For each file, it lists the filename, maximum and average number of probes, the distinct
  * words in alphabetical order with their frequency of occurrence, and ends with a separator line of dashes.
+ *
+ * Options:
+ *   --engine bst|hash|btree|radix
+ *                        Counting engine. 'bst' (the default) is the binary search tree; 'hash' counts in an
+ *                        open-addressing hash table and sorts the words once when writing the report. With 'hash' the
+ *                        probe lines describe hash lookups (slots inspected per word) and the number in parentheses
+ *                        is the word's displacement from its home slot instead of its tree level. 'btree' counts in a
+ *                        B-tree of fixed-size nodes holding up to 31 words each; probes are node visits and the
+ *                        number in parentheses is the depth of the node holding the word. 'radix' counts in a
+ *                        compressed radix trie that stores shared prefixes once, for the smallest memory footprint
+ *                        on large vocabularies; probes are the trie nodes visited and the number in parentheses is
+ *                        the depth of the node where the word ends. --balance does not apply to 'hash', 'btree' or
+ *                        'radix'.
+ *   --balance none|avl|splay
+ *                        Tree balancing strategy. 'avl' keeps the tree height O(log n) on sorted input; 'splay'
+ *                        moves every word to the root when it is seen, keeping frequent words near the top. The
+ *                        reported levels and probes then describe the resulting tree. Defaults to the build-time
+ *                        choice (see TEXTANALYSIS_BALANCED in CMakeLists.txt).
+ *   --ingest mmap|getline
+ *                        How input files are read. 'mmap' (the default) maps each file window by window and splits
+ *                        words straight out of the mapping; 'getline' is the original line-by-line reader. Both apply
+ *                        the same tokenization rules and produce identical output.
+ *   --kernel auto|scalar|sse2|avx2
+ *                        Byte classification kernel used by the 'mmap' tokenizer. 'auto' (the default) picks AVX2
+ *                        when the CPU supports it and SSE2 otherwise; all kernels produce identical words.
+ *   --jobs N             Analyze up to N files at once (0 = one per hardware thread). Every worker builds its own tree
+ *                        per file and renders the report block into memory; the blocks are written in the order of
+ *                        'input.txt', so the output is byte-identical to a serial run. Defaults to 1.
+ *   --split N            Split every file into up to N parts at word boundaries and count each part on its own thread
+ *                        (0 = one part per hardware thread). The per-part trees are merged by adding up frequencies,
+ *                        and the merged words are rebuilt into a perfectly balanced tree: the middle word of every
+ *                        alphabetical range is that range's root. Levels, maximum and average probes then describe
+ *                        this balanced tree, so the report depends only on the file's words and their counts, not on
+ *                        N or on the --balance mode (with the other engines the merged words are loaded into a
+ *                        fresh table, B-tree or trie). Implies '--ingest mmap'. Combines with --jobs, giving up to
+ *                        jobs x N threads.
+ *   --optimize           Once a file has been counted, rebuild its tree to minimize the frequency-weighted number of
+ *                        probes: the exact optimal BST for vocabularies of up to 1000 words, Mehlhorn's weight-balanced
+ *                        tree above that. Levels and probe statistics describe the rebuilt tree. Implies
+ *                        --weighted-probes. Has no effect with the other engines.
+ *   --weighted-probes    Add a "Weighted average number of probes" line after the average, where each word counts as
+ *                        many times as it occurs: the expected cost of looking up a word taken from the text.
+ *   --cache DIR          Keep a word index per file in DIR (created if missing) and reuse it on later runs: a file whose
+ *                        size and modification time are unchanged, analyzed with the same --engine, --balance,
+ *                        --split and --optimize choices and the same tokenization rules, is not read at all and its
+ *                        report block comes straight from the memory-mapped index. Any other file is analyzed and
+ *                        its index (re)written. Cached and fresh reports are byte-identical.
+ *   --memstats           Print, per file, how much memory the tree's node and word arenas used (in total and per
+ *                        distinct word) and how many heap allocations they saved compared to allocating every node
+ *                        and word individually.
+ *   --stats FILE         Write per-file and aggregate telemetry to FILE: CSV if its name ends in '.csv', JSON
+ *                        otherwise.
+ *                        Each record gives the wall time of every phase (cache lookup and save, ingest, --split
+ *                        merge, --optimize rebuild, report rendering), the bytes read, the words and distinct words,
+ *                        and, for the 'bst' engine, the word comparisons made while inserting, the nodes allocated
+ *                        and the deepest level an insertion reached (null or empty for the other engines). With
+ *                        --split, node allocations count the final tree only, not the temporary trees of the parts.
+ *                        Ingest is divided into inserting and reading/tokenizing by gathering the words into batches
+ *                        of 4096 and timing the insertion loop over each batch; with --split, the parts' share of
+ *                        time spent inserting is applied to the wall time of the ingest. Only available when the
+ *                        program is built with TEXTANALYSIS_INSTRUMENTATION (the default); builds without it carry
+ *                        no counting code at all.
+ *   --stream PATH|-      Count the words of an unbounded stream (a named pipe, or standard input with '-') instead of
+ *                        the files listed in 'input.txt', in memory fixed by --stream-memory. Every word goes into a
+ *                        Count-Min sketch, and a Space-Saving tracker follows the candidate most frequent words. Every
+ *                        --snapshot-every words and at the end of the stream, a snapshot of the top --top words is
+ *                        written to 'output.txt': the stream name, "Words counted: N", "Maximum overestimate: E",
+ *                        then 'word count (overestimate)' lines, most frequent first, and the separator line. A listed
+ *                        count is never below the word's true count and exceeds it by at most the number in
+ *                        parentheses, which is never more than E; any word occurring more than E times is listed
+ *                        unless --top words with higher counts fill the list. Words longer than 40 bytes are counted
+ *                        but never listed.
+ *   --stream-memory BYTES
+ *                        Memory used by --stream, split evenly between the sketch and the tracker; accepts K, M and
+ *                        G suffixes. Larger budgets give smaller overestimates. Defaults to 16M.
+ *   --top K              Number of words listed by every stream snapshot. Defaults to 20.
+ *   --snapshot-every N   Number of words counted between stream snapshots. Defaults to 1000000.
  */
 
 /*
@@ -29,7 +106,8 @@
  * The program utilizes the following approach to analyze text files and track word occurrences:
  * 1. Read the list of filenames from 'input.txt'.
  * 2. For each filename:
- *    a. Open the file and read its contents line by line.
+ *    a. Open the file and map its contents into memory window by window (or read it line by line with
+ *       '--ingest getline').
  *    b. For each line, process it to identify distinct words, taking care of case-insensitivity, hyphenated words,
  *       and ignoring apostrophes followed by 's'.
  *    c. Insert each distinct word into a BST, or increment its frequency if it already exists.
@@ -80,81 +158,910 @@
  * - O(m log n) for inserting words into the BST, where m is the total number of words read and n is the number of distinct
  *   words. This is for a balanced BST; however, in the worst case of an unbalanced tree, this could degrade to O(mn).
  * - O(n) for the in-order traversal of the BST to output words in alphabetical order.
+ * - With '--optimize', O(n^2) time and space for the exact optimal tree (n <= 1000), O(n log n) for the weight-balanced
+ *   rebuild of larger vocabularies.
  *
- * The overall efficiency of the algorithm is highly dependent on the structure of the BST, with the potential for optimization
- * through self-balancing trees to ensure O(m log n) performance consistently.
+ * The overall efficiency of the algorithm is highly dependent on the structure of the BST. Running with '--balance avl'
+ * keeps the tree height-balanced through rotations, which guarantees O(m log n) even on sorted input.
  */
 
 // necessary header files
 #include "TextAnalysisBST.h"
+#include "TextAnalysisBTree.h"
+#include "TextAnalysisHash.h"
+#include "TextAnalysisIndex.h"
+#include "TextAnalysisRadix.h"
+#include "TextAnalysisSketch.h"
+#include "TextAnalysisTokenizer.h"
+#include <algorithm>
 #include <fstream>
+#include <iomanip>
 #include <iostream>
-#include <cctype>
+#include <cerrno>
+#include <chrono>
+#include <condition_variable>
+#include <cstdlib>
 #include <cstring>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <sys/stat.h>
+
+// How the words of an input file are read
+enum class IngestMode
+{
+    Mapped, // Memory-mapped, zero-copy tokenizer
+    Getline // Line-by-line reading through splitAndProcessWords
+};
+
+// Which engine counts the words of a file
+enum class EngineKind
+{
+    BST,  // WordBST
+    Hash,  // HashWordCounter
+    BTree, // BTreeWordCounter
+    Radix  // RadixWordCounter
+};
+
+// Command line options controlling how the files are analyzed
+struct Options
+{
+    EngineKind engine = EngineKind::BST;                // Counting engine used for each file
+    IngestMode ingest = IngestMode::Mapped;             // How input files are read
+    BalanceMode balance = TEXTANALYSIS_DEFAULT_BALANCE; // Balancing strategy for each file's BST
+    TokenizerKernel kernel = TokenizerKernel::Auto;     // Classification kernel for the mapped tokenizer
+    unsigned jobs = 1;                                  // Number of files analyzed concurrently
+    unsigned split = 0;                                 // Parts counted concurrently within each file (0 = off)
+    bool optimize = false;                              // Rebuild each tree for frequency-weighted lookups
+    bool weightedProbes = false;                        // Report the frequency-weighted average probes
+    bool memoryStats = false;                           // Print arena usage for each file
+    std::string cacheDirectory;                         // Where word indexes are kept (empty = no caching)
+    std::string streamSource;                           // Stream counted instead of the files (empty = off, - = stdin)
+    std::size_t streamMemory = 16 * 1024 * 1024;        // Memory budget of the streaming structures, in bytes
+    std::size_t topCount = 20;                          // Words listed by every stream snapshot
+    std::uint64_t snapshotInterval = 1000000;           // Words counted between stream snapshots
+    std::string statsFile;                              // Where the --stats telemetry is written (empty = off)
+};
+
+/**
+ * Parses a positive byte count with an optional K, M or G suffix (powers of 1024).
+ *
+ * @param text The argument to parse.
+ * @param bytes Receives the number of bytes.
+ * @return true if the argument is a valid size, false otherwise.
+ */
+bool parseByteCount(const char *text, std::size_t &bytes)
+{
+    char *end;
+    unsigned long long value = std::strtoull(text, &end, 10);
+    unsigned shift = 0;
+    if (*end == 'K' || *end == 'k')
+    {
+        shift = 10;
+    }
+    else if (*end == 'M' || *end == 'm')
+    {
+        shift = 20;
+    }
+    else if (*end == 'G' || *end == 'g')
+    {
+        shift = 30;
+    }
+    if (shift > 0)
+    {
+        end++;
+    }
+    if (end == text || *end != '\0' || *text == '-' || value == 0 || value > (SIZE_MAX >> shift))
+    {
+        return false;
+    }
+    bytes = static_cast<std::size_t>(value) << shift;
+    return true;
+}
+
+/**
+ * Parses the command line into an Options structure.
+ *
+ * @param argc The argument count passed to main.
+ * @param argv The argument vector passed to main.
+ * @param options The options to fill in.
+ * @return true if every argument was recognized, false otherwise.
+ */
+bool parseOptions(int argc, char *argv[], Options &options)
+{
+    for (int i = 1; i < argc; i++)
+    {
+        std::string arg = argv[i];
+        if (arg == "--engine" && i + 1 < argc)
+        {
+            std::string value = argv[++i];
+            if (value == "bst")
+            {
+                options.engine = EngineKind::BST;
+            }
+            else if (value == "hash")
+            {
+                options.engine = EngineKind::Hash;
+            }
+            else if (value == "btree")
+            {
+                options.engine = EngineKind::BTree;
+            }
+            else if (value == "radix")
+            {
+                options.engine = EngineKind::Radix;
+            }
+            else
+            {
+                std::cerr << "Unknown engine: " << value << std::endl;
+                return false;
+            }
+        }
+        else if (arg == "--balance" && i + 1 < argc)
+        {
+            std::string value = argv[++i];
+            if (value == "none")
+            {
+                options.balance = BalanceMode::None;
+            }
+            else if (value == "avl")
+            {
+                options.balance = BalanceMode::AVL;
+            }
+            else if (value == "splay")
+            {
+                options.balance = BalanceMode::Splay;
+            }
+            else
+            {
+                std::cerr << "Unknown balance mode: " << value << std::endl;
+                return false;
+            }
+        }
+        else if (arg == "--ingest" && i + 1 < argc)
+        {
+            std::string value = argv[++i];
+            if (value == "mmap")
+            {
+                options.ingest = IngestMode::Mapped;
+            }
+            else if (value == "getline")
+            {
+                options.ingest = IngestMode::Getline;
+            }
+            else
+            {
+                std::cerr << "Unknown ingest mode: " << value << std::endl;
+                return false;
+            }
+        }
+        else if (arg == "--kernel" && i + 1 < argc)
+        {
+            std::string value = argv[++i];
+            bool known = false;
+            for (TokenizerKernel kernel : {TokenizerKernel::Auto, TokenizerKernel::Scalar, TokenizerKernel::SSE2,
+                                           TokenizerKernel::AVX2})
+            {
+                if (value == tokenizerKernelName(kernel))
+                {
+                    options.kernel = kernel;
+                    known = true;
+                }
+            }
+            if (!known)
+            {
+                std::cerr << "Unknown kernel: " << value << std::endl;
+                return false;
+            }
+        }
+        else if ((arg == "--jobs" || arg == "--split") && i + 1 < argc)
+        {
+            char *end;
+            long value = std::strtol(argv[++i], &end, 10);
+            if (*end != '\0' || value < 0)
+            {
+                std::cerr << "Invalid thread count: " << argv[i] << std::endl;
+                return false;
+            }
+            unsigned threads = value == 0 ? std::thread::hardware_concurrency() : static_cast<unsigned>(value);
+            if (threads == 0)
+            {
+                threads = 1; // hardware_concurrency may be unknown
+            }
+            (arg == "--jobs" ? options.jobs : options.split) = threads;
+        }
+        else if (arg == "--optimize")
+        {
+            options.optimize = true;
+            options.weightedProbes = true;
+        }
+        else if (arg == "--weighted-probes")
+        {
+            options.weightedProbes = true;
+        }
+        else if (arg == "--cache" && i + 1 < argc)
+        {
+            options.cacheDirectory = argv[++i];
+        }
+        else if (arg == "--memstats")
+        {
+            options.memoryStats = true;
+        }
+        else if (arg == "--stats" && i + 1 < argc)
+        {
+            options.statsFile = argv[++i];
+        }
+        else if (arg == "--stream" && i + 1 < argc)
+        {
+            options.streamSource = argv[++i];
+        }
+        else if (arg == "--stream-memory" && i + 1 < argc)
+        {
+            if (!parseByteCount(argv[++i], options.streamMemory))
+            {
+                std::cerr << "Invalid memory budget: " << argv[i] << std::endl;
+                return false;
+            }
+        }
+        else if ((arg == "--top" || arg == "--snapshot-every") && i + 1 < argc)
+        {
+            char *end;
+            long long value = std::strtoll(argv[++i], &end, 10);
+            if (*end != '\0' || value <= 0)
+            {
+                std::cerr << "Invalid count: " << argv[i] << std::endl;
+                return false;
+            }
+            if (arg == "--top")
+            {
+                options.topCount = static_cast<std::size_t>(value);
+            }
+            else
+            {
+                options.snapshotInterval = static_cast<std::uint64_t>(value);
+            }
+        }
+        else
+        {
+            std::cerr << "Unknown option: " << arg << std::endl;
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * Creates the counting engine selected on the command line.
+ *
+ * @param options The command line options.
+ * @return A new, empty counter.
+ */
+std::unique_ptr<WordCounter> createCounter(const Options &options)
+{
+    std::unique_ptr<WordCounter> counter;
+    if (options.engine == EngineKind::Hash)
+    {
+        counter.reset(new HashWordCounter());
+    }
+    else if (options.engine == EngineKind::BTree)
+    {
+        counter.reset(new BTreeWordCounter());
+    }
+    else if (options.engine == EngineKind::Radix)
+    {
+        counter.reset(new RadixWordCounter());
+    }
+    else
+    {
+        counter.reset(new WordBST(options.balance));
+    }
+    counter->setReportWeightedProbes(options.weightedProbes);
+    return counter;
+}
+
+// Words inserted per timed batch when --stats is given
+static const std::size_t insertBatchSize = 4096;
+
+// Returns the seconds elapsed since a start time, for --stats
+static double secondsSince(std::chrono::steady_clock::time_point start)
+{
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+// Adapter inserting every word produced by a Tokenizer into a counting engine
+class CounterTokenSink : public TokenSink
+{
+public:
+    /**
+     * Constructor to initialize an adapter.
+     * @param counter The engine receiving the words.
+     * @param stats Receives the token count and the insertion time, or nullptr when --stats is off.
+     */
+    explicit CounterTokenSink(WordCounter &counter, FileStats *stats = nullptr) : counter(counter), stats(stats) {}
+
+    void consumeToken(std::string_view word) override
+    {
+#if TEXTANALYSIS_STATS
+        if (stats != nullptr)
+        {
+            // Reading the clock around every insertion would cost more than most insertions, so the words are
+            // gathered into batches and the insertion loop over each batch is timed as a whole
+            stats->tokens++;
+            batchText.append(word.data(), word.size());
+            batchEnds.push_back(batchText.size());
+            if (batchEnds.size() == insertBatchSize)
+            {
+                insertBatch();
+            }
+            return;
+        }
+#endif
+        counter.insert(word);
+    }
+
+    /**
+     * Inserts the words still waiting in the current batch; must be called once the tokenizer has finished.
+     */
+    void finish()
+    {
+#if TEXTANALYSIS_STATS
+        if (stats != nullptr && !batchEnds.empty())
+        {
+            insertBatch();
+        }
+#endif
+    }
+
+private:
+    WordCounter &counter;               // Engine receiving the words
+    FileStats *stats;                   // Telemetry of the file, nullptr when --stats is off
+    std::string batchText;              // Words of the current batch back to back, for --stats
+    std::vector<std::size_t> batchEnds; // End offset of every word of the current batch in batchText
+
+    // Inserts the current batch, adding the time of the insertion loop to the insert phase, and empties it
+    void insertBatch()
+    {
+        auto start = std::chrono::steady_clock::now();
+        std::size_t begin = 0;
+        for (std::size_t end : batchEnds)
+        {
+            counter.insert(std::string_view(batchText).substr(begin, end - begin));
+            begin = end;
+        }
+        stats->seconds.insert += secondsSince(start);
+        batchText.clear();
+        batchEnds.clear();
+    }
+};
+
+/**
+ * Counts the words of a file on several threads. The file is cut at word boundaries into up to options.split
+ * parts, each part is counted into a private engine, and the sorted contents of those engines are merged and
+ * rebuilt into the result (a balanced tree for the BST, see --split in the header comment).
+ *
+ * @param fileName The file to read.
+ * @param options The command line options, giving the number of parts and the engine of the parts.
+ * @param counter The empty engine receiving the merged words.
+ * @param stats Receives the telemetry of the parts and the merge time, or nullptr when --stats is off.
+ * @return true on success, false if the file could not be opened or read.
+ */
+bool readWordsSplit(const std::string &fileName, const Options &options, WordCounter &counter, FileStats *stats)
+{
+    std::vector<std::uint64_t> boundaries;
+    bool splittable = splitAtWordBoundaries(fileName, options.split, boundaries);
+    std::size_t parts = splittable ? boundaries.size() - 1 : 1; // Pipes and other streams are read in one part
+
+    std::vector<std::unique_ptr<WordCounter>> partTrees;
+    std::vector<FileStats> partStats(parts);
+    std::vector<char> succeeded(parts, 0);
+    std::vector<std::thread> threads;
+    for (std::size_t part = 0; part < parts; part++)
+    {
+        partTrees.emplace_back(createCounter(options));
+    }
+    auto ingestStart = std::chrono::steady_clock::now();
+    for (std::size_t part = 0; part < parts; part++)
+    {
+        threads.emplace_back([&, part]()
+                             {
+                                 auto partStart = std::chrono::steady_clock::now();
+                                 CounterTokenSink sink(*partTrees[part], stats ? &partStats[part] : nullptr);
+                                 succeeded[part] = splittable ? tokenizeFileRange(fileName, boundaries[part],
+                                                                                  boundaries[part + 1], sink)
+                                                              : tokenizeFile(fileName, sink);
+                                 sink.finish();
+                                 partStats[part].seconds.ingest = secondsSince(partStart);
+                             });
+    }
+    for (std::thread &thread : threads)
+    {
+        thread.join();
+    }
+    double ingestSeconds = secondsSince(ingestStart);
+    for (char success : succeeded)
+    {
+        if (!success)
+        {
+            return false;
+        }
+    }
+
+    auto mergeStart = std::chrono::steady_clock::now();
+    std::vector<std::vector<WordCount>> runs(parts);
+    for (std::size_t part = 0; part < parts; part++)
+    {
+        partTrees[part]->collectInOrder(runs[part]);
+    }
+    std::vector<WordCount> merged;
+    mergeSortedRuns(runs, merged);
+    counter.buildFromSorted(merged); // Copies the words, so the part trees can go away afterwards
+
+    if (stats != nullptr)
+    {
+        stats->seconds.merge = secondsSince(mergeStart);
+        double partSeconds = 0, partInsertSeconds = 0;
+        for (std::size_t part = 0; part < parts; part++)
+        {
+            InsertStats partCounters;
+            stats->tokens += partStats[part].tokens;
+            partSeconds += partStats[part].seconds.ingest;
+            partInsertSeconds += partStats[part].seconds.insert;
+            // The part trees are temporary: only the final tree's nodes are reported as allocations
+            if (partTrees[part]->getInsertStats(partCounters))
+            {
+                stats->engine.comparisons += partCounters.comparisons;
+                stats->engine.peakDepth = std::max(stats->engine.peakDepth, partCounters.peakDepth);
+            }
+        }
+        // The parts ran side by side, so their summed insertion time is turned into a share of the wall time
+        stats->seconds.insert = partSeconds == 0 ? 0 : ingestSeconds * partInsertSeconds / partSeconds;
+    }
+    return true;
+}
+
+/**
+ * Reads every word of a file into a counting engine using the selected ingest mode.
+ *
+ * @param fileName The file to read.
+ * @param options The command line options, selecting the ingest mode.
+ * @param wordBST The engine receiving the words.
+ * @param stats Receives the token count and insertion time, or nullptr when --stats is off.
+ * @return true on success, false if the file could not be opened or read.
+ */
+bool ingestWords(const std::string &fileName, const Options &options, WordCounter &wordBST, FileStats *stats)
+{
+    if (options.split > 0)
+    {
+        return readWordsSplit(fileName, options, wordBST, stats);
+    }
+    CounterTokenSink sink(wordBST, stats);
+    bool read = options.ingest == IngestMode::Mapped ? tokenizeFile(fileName, sink)
+                                                     : tokenizeFileByLines(fileName, sink);
+    sink.finish();
+    return read;
+}
+
+/**
+ * Reads every word of a file into a counting engine, then optimizes the engine for lookups if requested.
+ *
+ * @param fileName The file to read.
+ * @param options The command line options.
+ * @param counter The engine receiving the words.
+ * @param stats Receives the ingest, merge and optimize times and the counters, or nullptr when --stats is off.
+ * @return true on success, false if the file could not be opened or read.
+ */
+bool readWords(const std::string &fileName, const Options &options, WordCounter &counter, FileStats *stats)
+{
+    auto start = std::chrono::steady_clock::now();
+    if (!ingestWords(fileName, options, counter, stats))
+    {
+        return false;
+    }
+    if (stats != nullptr)
+    {
+        stats->seconds.ingest = secondsSince(start) - stats->seconds.merge;
+        start = std::chrono::steady_clock::now();
+    }
+    if (options.optimize)
+    {
+        counter.optimizeForLookups();
+    }
+    if (stats != nullptr)
+    {
+        stats->seconds.optimize = secondsSince(start);
+    }
+    return true;
+}
+
+/**
+ * Summarizes the options that change the content of a report, so that a cached index is only reused by runs
+ * that would produce the same report. The ingest mode and kernel do not change the words, and --split N gives
+ * the same tree for every N, so they are left out; the weighted line is rendered from the index either way.
+ *
+ * @param options The command line options.
+ * @return The configuration stored in IndexKey.
+ */
+std::uint32_t cacheConfiguration(const Options &options)
+{
+    return static_cast<std::uint32_t>(options.engine) | static_cast<std::uint32_t>(options.balance) << 4 |
+           (options.optimize ? 1u : 0u) << 8 | (options.split > 0 ? 1u : 0u) << 9;
+}
+
+// Memory used by the engine that counted a file, for --memstats
+struct MemoryUsage
+{
+    ArenaStats arena;              // Combined usage of the engine's arenas and tables
+    std::size_t distinctWords = 0; // Number of distinct words the engine holds
+};
+
+// Outcome of analyzing one file
+enum class FileOutcome
+{
+    Failed,  // The file could not be opened or read
+    Counted, // The words were counted by a new engine
+    Cached   // The report came from the file's cached index
+};
 
 /**
- * Processes each character of the input text, building words to insert into the binary search tree (BST).
- * Handles alphanumeric characters and hyphens, and ignores other punctuation, treating words case-insensitively.
- * Also handles special cases where a word ends with an apostrophe followed by 's', removing the trailing 's.
+ * Appends the report block of one file (its name, then the engine's report) to a buffer, using the cached index
+ * when --cache is given and the index is current, and counting the words otherwise (saving a new index).
  *
- * @param currentChar The current character being processed from the text.
- * @param currentWord The current word being built from consecutive characters.
- * @param wordBST The binary search tree where the word will be inserted.
- * @param isWord A flag indicating whether the current sequence of characters constitutes a word.
+ * @param fileName The file to analyze.
+ * @param options The command line options.
+ * @param out The buffer receiving the block; left unchanged if the file cannot be read.
+ * @param memory Receives the memory used by the engine when the file was counted.
+ * @param stats Receives the file's telemetry, or nullptr when --stats is off.
+ * @return How the block was produced.
  */
-void processCharacterAndWord(char currentChar, std::string &currentWord, WordBST &wordBST, bool &isWord)
+FileOutcome analyzeFile(const std::string &fileName, const Options &options, ReportBuffer &out, MemoryUsage &memory,
+                        FileStats *stats)
 {
-    if (std::isalnum(currentChar) || currentChar == '-')
+    auto start = std::chrono::steady_clock::now();
+    IndexKey key;
+    key.configuration = cacheConfiguration(options);
+    // The key is taken before reading, so a file changed while it is read is analyzed again next time
+    bool cacheable = !options.cacheDirectory.empty() && describeIndexSource(fileName, key);
+    std::string indexPath = cacheable ? indexPathFor(options.cacheDirectory, key) : std::string();
+    if (cacheable)
+    {
+        WordIndex index;
+        if (index.open(indexPath, key))
+        {
+            out.append(fileName);
+            out.append('\n');
+            auto reportStart = std::chrono::steady_clock::now();
+            index.writeReport(out, options.weightedProbes);
+            if (stats != nullptr)
+            {
+                stats->seconds.report = secondsSince(reportStart);
+                stats->seconds.cache = std::chrono::duration<double>(reportStart - start).count();
+                stats->seconds.total = secondsSince(start);
+                stats->distinctWords = index.size();
+            }
+            return FileOutcome::Cached;
+        }
+    }
+    if (stats != nullptr)
+    {
+        stats->seconds.cache = secondsSince(start);
+    }
+
+    std::unique_ptr<WordCounter> counter = createCounter(options); // Each file gets its own engine
+    if (!readWords(fileName, options, *counter, stats))
     {
-        currentWord += std::tolower(currentChar);
-        isWord = true;
+        return FileOutcome::Failed;
     }
-    else if (isWord)
+    auto reportStart = std::chrono::steady_clock::now();
+    out.append(fileName); // Write the filename as part of the analysis
+    out.append('\n');
+    auto saveStart = reportStart;
+    if (cacheable)
     {
-        // Check for trailing 's in words and remove it
-        if (currentWord.length() > 2 && currentWord.substr(currentWord.length() - 2) == "'s")
+        // One traversal of the engine feeds both the report and the index
+        std::vector<ReportEntry> entries;
+        ProbeStatistics statistics;
+        counter->collectReport(entries, statistics);
+        appendReport(out, entries, statistics, options.weightedProbes);
+        saveStart = std::chrono::steady_clock::now();
+        if (!WordIndex::save(indexPath, key, entries, statistics))
         {
-            currentWord = currentWord.substr(0, currentWord.length() - 2);
+            std::cerr << "Failed to save the index of " << fileName << std::endl;
         }
-        wordBST.insert(currentWord); // Insert the current word into the BST
-        currentWord = "";            // Reset currentWord for the next word
-        isWord = false;              // Reset isWord flag as we've finished processing a word
     }
+    else
+    {
+        counter->writeReport(out); // Streamed, so the vocabulary is never collected
+        saveStart = std::chrono::steady_clock::now();
+    }
+    memory.arena = counter->getArenaStats();
+    memory.distinctWords = counter->distinctWords();
+
+    if (stats != nullptr)
+    {
+        struct stat info;
+        stats->seconds.report = std::chrono::duration<double>(saveStart - reportStart).count();
+        stats->seconds.cache += secondsSince(saveStart);
+        stats->seconds.total = secondsSince(start);
+        stats->bytesRead = stat(fileName.c_str(), &info) == 0 && S_ISREG(info.st_mode)
+                               ? static_cast<std::uint64_t>(info.st_size)
+                               : 0;
+        stats->distinctWords = memory.distinctWords;
+        InsertStats counters;
+        if (counter->getInsertStats(counters))
+        {
+            stats->engineCounters = true;
+            stats->engine.comparisons += counters.comparisons;
+            stats->engine.nodeAllocations += counters.nodeAllocations;
+            stats->engine.peakDepth = std::max(stats->engine.peakDepth, counters.peakDepth);
+        }
+    }
+    return FileOutcome::Counted;
 }
 
 /**
- * Processes a line of text, extracting words and inserting them into the binary search tree (BST).
- * Utilizes processCharacterAndWord for character-by-character processing.
+ * Prints how much memory a file's tree used, per distinct word, and what the arenas saved over one heap allocation
+ * per node and per word. Saved bytes are an estimate based on the per-allocation bookkeeping of a typical malloc.
  *
- * @param text The line of text to be processed.
- * @param wordBST The binary search tree for inserting extracted words.
+ * @param fileName The file the tree was built from.
+ * @param memory The memory used by the tree.
  */
-void splitAndProcessWords(const std::string &text, WordBST &wordBST)
+void printArenaStats(const std::string &fileName, const MemoryUsage &memory)
 {
-    std::string currentWord;
-    bool isWord = false;
-    for (char c : text)
+    const ArenaStats &stats = memory.arena;
+    const std::size_t mallocOverhead = 2 * sizeof(std::size_t);
+    std::size_t saved = stats.allocations > stats.blocks ? stats.allocations - stats.blocks : 0;
+    double bytesPerWord = memory.distinctWords == 0 ? 0 : static_cast<double>(stats.bytesUsed) / memory.distinctWords;
+    std::cout << fileName << ": " << stats.allocations << " allocations served from " << stats.blocks
+              << " blocks (" << stats.bytesUsed << " of " << stats.bytesReserved << " bytes used), "
+              << saved << " heap allocations saved, ~" << saved * mallocOverhead << " bytes of malloc overhead saved, "
+              << memory.distinctWords << " distinct words, " << std::fixed << std::setprecision(1) << bytesPerWord
+              << " bytes per distinct word" << std::endl;
+}
+
+/**
+ * Prints the --memstats line of a file: the arena usage of its tree, or a note that no tree was built because the
+ * report came from the cache.
+ *
+ * @param fileName The analyzed file.
+ * @param outcome How the file's report was produced.
+ * @param memory The memory used by the tree, if one was built.
+ */
+void printMemoryStats(const std::string &fileName, FileOutcome outcome, const MemoryUsage &memory)
+{
+    if (outcome == FileOutcome::Cached)
     {
-        processCharacterAndWord(c, currentWord, wordBST, isWord);
+        std::cout << fileName << ": report read from the index cache, no tree built" << std::endl;
+        return;
     }
-    // Process the last word if the line ends with a word character
-    if (isWord)
+    printArenaStats(fileName, memory);
+}
+
+// Result of analyzing one file in parallel mode, handed from a worker to the writer
+struct FileReport
+{
+    bool ready = false;                        // Set once the worker has filled in the fields below
+    FileOutcome outcome = FileOutcome::Failed; // How the report block was produced
+    ReportBuffer text;                         // Rendered report block, starting with the file name line
+    MemoryUsage memory;                        // Memory used by the file's tree, for --memstats
+    FileStats stats;                           // Telemetry of the file, for --stats
+};
+
+/**
+ * Completes a file's telemetry with its name and outcome and appends it to the --stats records.
+ *
+ * @param fileName The analyzed file.
+ * @param outcome How the file's report was produced.
+ * @param stats The telemetry gathered by analyzeFile.
+ * @param fileStats The records of the run, in input order.
+ */
+void recordFileStats(const std::string &fileName, FileOutcome outcome, FileStats &stats,
+                     std::vector<FileStats> &fileStats)
+{
+    stats.fileName = fileName;
+    stats.outcome =
+        outcome == FileOutcome::Cached ? "cached" : (outcome == FileOutcome::Counted ? "counted" : "failed");
+    fileStats.push_back(stats);
+}
+
+/**
+ * Analyzes the files on a pool of worker threads. Each worker claims the next file, builds its own BST and
+ * renders the report block into memory; the calling thread writes the blocks (and any error or memory
+ * messages) strictly in input order. Workers stay at most a few files ahead of the writer so that finished
+ * reports do not pile up in memory behind a slow file.
+ *
+ * @param fileNames The files to analyze, in input order.
+ * @param options The command line options.
+ * @param outFile The report writer the blocks are appended to.
+ * @param fileStats Receives the telemetry of every file, in input order, when --stats is given.
+ */
+void processFilesInParallel(const std::vector<std::string> &fileNames, const Options &options, ReportWriter &outFile,
+                            std::vector<FileStats> &fileStats)
+{
+    std::vector<FileReport> reports(fileNames.size());
+    std::mutex mutex;                    // Guards the fields below and the ready flags
+    std::condition_variable changed;     // Signalled when a report is ready or the writer advances
+    std::size_t nextFile = 0;            // Next file to hand to a worker
+    std::size_t written = 0;             // Number of reports already written
+    const std::size_t maxAhead = 4 * options.jobs; // Files a worker may run ahead of the writer
+
+    auto worker = [&]()
+    {
+        while (true)
+        {
+            std::size_t index;
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                changed.wait(lock, [&]() { return nextFile >= fileNames.size() || nextFile < written + maxAhead; });
+                if (nextFile >= fileNames.size())
+                {
+                    return;
+                }
+                index = nextFile++;
+            }
+
+            FileReport report;
+            report.outcome = analyzeFile(fileNames[index], options, report.text, report.memory,
+                                         options.statsFile.empty() ? nullptr : &report.stats);
+
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                reports[index] = std::move(report);
+                reports[index].ready = true;
+            }
+            changed.notify_all();
+        }
+    };
+
+    std::vector<std::thread> workers;
+    for (unsigned i = 0; i < options.jobs; i++)
     {
-        wordBST.insert(currentWord);
+        workers.emplace_back(worker);
     }
+
+    for (std::size_t index = 0; index < fileNames.size(); index++)
+    {
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            changed.wait(lock, [&]() { return reports[index].ready; });
+        }
+
+        // The worker is done with this report, so it can be used without holding the lock
+        FileReport &report = reports[index];
+        if (report.outcome == FileOutcome::Failed)
+        {
+            std::cerr << "Failed to open " << fileNames[index] << std::endl;
+        }
+        else
+        {
+            outFile.writeBlock(report.text.view());
+            if (options.memoryStats)
+            {
+                printMemoryStats(fileNames[index], report.outcome, report.memory);
+            }
+        }
+        report.text = ReportBuffer(); // Release the block as soon as it is written
+        if (!options.statsFile.empty())
+        {
+            recordFileStats(fileNames[index], report.outcome, report.stats, fileStats);
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            written = index + 1;
+        }
+        changed.notify_all();
+    }
+
+    for (std::thread &thread : workers)
+    {
+        thread.join();
+    }
+}
+
+// Adapter counting every word of a stream and writing a snapshot of the top words at a fixed interval
+class SnapshotTokenSink : public TokenSink
+{
+public:
+    SnapshotTokenSink(StreamingTopK &tracker, const Options &options, ReportWriter &outFile, std::string_view source)
+        : tracker(tracker), interval(options.snapshotInterval), outFile(outFile), source(source)
+    {
+    }
+
+    void consumeToken(std::string_view word) override
+    {
+        tracker.consumeToken(word);
+        if (tracker.wordsCounted() % interval == 0)
+        {
+            tracker.writeSnapshot(outFile, source);
+            outFile.flush(); // Readers following the output see every snapshot as soon as it is taken
+        }
+    }
+
+private:
+    StreamingTopK &tracker;  // Structures counting the stream
+    std::uint64_t interval;  // Words counted between snapshots
+    ReportWriter &outFile;   // Receiver of the snapshots
+    std::string_view source; // Name of the stream printed on every snapshot
+};
+
+/**
+ * Counts the words of a stream (standard input or a named pipe) in bounded memory, writing a snapshot of the
+ * approximate top words every options.snapshotInterval words and once more at the end of the stream.
+ *
+ * @param options The command line options, naming the stream and the memory budget.
+ * @param outFile The report writer receiving the snapshots.
+ * @return true on success, false if the stream could not be opened or read.
+ */
+bool processStream(const Options &options, ReportWriter &outFile)
+{
+    StreamingTopK tracker(options.streamMemory, options.topCount);
+    if (tracker.capacity() < options.topCount)
+    {
+        std::cerr << "A memory budget of " << options.streamMemory << " bytes cannot track the top "
+                  << options.topCount << " words." << std::endl;
+        return false;
+    }
+    bool standardInput = options.streamSource == "-";
+    std::string source = standardInput ? "stdin" : options.streamSource;
+    SnapshotTokenSink sink(tracker, options, outFile, source);
+    if (!tokenizeFile(standardInput ? "/dev/stdin" : options.streamSource, sink))
+    {
+        std::cerr << "Failed to read " << source << std::endl;
+        return false;
+    }
+    if (tracker.wordsCounted() % options.snapshotInterval != 0 || tracker.wordsCounted() == 0)
+    {
+        tracker.writeSnapshot(outFile, source); // The final counts, unless a snapshot was just taken
+    }
+    return true;
 }
 
 // Main function: Orchestrates file reading, word processing, and output generation
-int main()
+int main(int argc, char *argv[])
 {
+    auto runStart = std::chrono::steady_clock::now();
+    Options options;
+    if (!parseOptions(argc, argv, options))
+    {
+        std::cerr << "Usage: " << argv[0] << " [--engine bst|hash|btree|radix] [--balance none|avl|splay]"
+                  << " [--ingest mmap|getline] [--kernel auto|scalar|sse2|avx2] [--jobs N] [--split N]"
+                  << " [--optimize] [--weighted-probes] [--cache DIR] [--memstats]"
+                  << " [--stats FILE] [--stream PATH|- [--stream-memory BYTES] [--top K] [--snapshot-every N]]"
+                  << std::endl;
+        return -1;
+    }
+    if (!options.statsFile.empty() && !TEXTANALYSIS_STATS)
+    {
+        std::cerr << "--stats needs a build with instrumentation (TEXTANALYSIS_INSTRUMENTATION in CMakeLists.txt)."
+                  << std::endl;
+        return -1;
+    }
+    if (!selectTokenizerKernel(options.kernel))
+    {
+        std::cerr << "The " << tokenizerKernelName(options.kernel) << " kernel is not supported on this machine."
+                  << std::endl;
+        return -1;
+    }
+
     // Open the input file containing filenames to process
     std::ifstream inputFile("../data/input.txt");
     std::string outputFileName = "../data/output.txt"; // Output file path
 
-    // Ensure outputFile is cleared at the beginning
-    std::ofstream outputFile(outputFileName, std::ofstream::trunc);
-    outputFile << "wejulu\n"; // Write ID to the output file
-    outputFile.close();       // Close to allow append mode in writeToFile
+    // A single writer keeps the output file open for the whole run and writes it in large chunks
+    ReportWriter outFile;
+    if (!outFile.open(outputFileName, false)) // Truncate the output at the beginning
+    {
+        std::cerr << "Failed to open the output file." << std::endl;
+        return -1;
+    }
+    outFile.append("wejulu\n"); // Write ID to the output file
+
+    if (!options.streamSource.empty())
+    {
+        bool success = processStream(options, outFile);
+        return outFile.close() && success ? 0 : -1;
+    }
 
     // Check if the input file opened successfully
     if (!inputFile.is_open())
@@ -163,35 +1070,68 @@ int main()
         return -1; // Exit with an error code
     }
 
-    std::string fileName; // Holds the current filename being processed
+    if (!options.cacheDirectory.empty() && mkdir(options.cacheDirectory.c_str(), 0755) != 0 && errno != EEXIST)
+    {
+        std::cerr << "Failed to create the cache directory " << options.cacheDirectory << std::endl;
+        return -1;
+    }
+
+    std::string fileName;             // Holds the current filename being processed
+    std::vector<FileStats> fileStats; // Telemetry of every file, for --stats
+
+    if (options.jobs > 1)
+    {
+        std::vector<std::string> fileNames;
+        while (std::getline(inputFile, fileName))
+        {
+            fileNames.push_back(fileName);
+        }
+        processFilesInParallel(fileNames, options, outFile, fileStats);
+    }
+
     // Iterate through each line (filename) in the input file
-    while (std::getline(inputFile, fileName))
+    while (options.jobs == 1 && std::getline(inputFile, fileName))
     {
-        std::ifstream file(fileName); // Open the current file to process
-        if (!file.is_open())
+        MemoryUsage memory;
+        FileStats stats;
+        FileOutcome outcome =
+            analyzeFile(fileName, options, outFile, memory, options.statsFile.empty() ? nullptr : &stats);
+        if (!options.statsFile.empty())
+        {
+            recordFileStats(fileName, outcome, stats, fileStats);
+        }
+        if (outcome == FileOutcome::Failed)
         {
             std::cerr << "Failed to open " << fileName << std::endl;
             continue; // Skip to the next file if this one fails to open
         }
+        outFile.flushIfFull();
 
-        WordBST wordBST;  // Create a new BST instance for this file
-        std::string line; // Holds the current line being processed
-        // Read and process each line in the file
-        while (std::getline(file, line))
+        if (options.memoryStats)
         {
-            splitAndProcessWords(line, wordBST); // Extract words and insert into BST
+            printMemoryStats(fileName, outcome, memory);
         }
+    }
 
-        file.close(); // Close the current file
-
-        // Open the output file in append mode and write file name
-        std::ofstream outFile(outputFileName, std::ios::app);
-        outFile << fileName << std::endl; // Write the filename as part of the analysis
-        outFile.close();
-
-        // Delegate the computation of probes and writing of words to the wordBST instance
-        wordBST.writeToFile(outputFileName);
+    if (!outFile.close())
+    {
+        std::cerr << "Failed to write the output file." << std::endl;
+        return -1;
     }
 
+    if (!options.statsFile.empty())
+    {
+        FileStats aggregate;
+        aggregate.outcome = "total";
+        for (const FileStats &stats : fileStats)
+        {
+            aggregate.add(stats);
+        }
+        if (!writeStatsSidecar(options.statsFile, fileStats, aggregate, secondsSince(runStart)))
+        {
+            std::cerr << "Failed to write the statistics file " << options.statsFile << std::endl;
+            return -1;
+        }
+    }
     return 0; // on success
 }
@@ -0,0 +1,88 @@
+// TextAnalysisArena.h
+#ifndef TEXTANALYSISARENA_H
+#define TEXTANALYSISARENA_H
+
+#include <cstddef>
+#include <string_view>
+#include <vector>
+
+/**
+ * Running totals describing how an arena has been used.
+ */
+struct ArenaStats
+{
+    std::size_t allocations = 0;   // Number of objects or strings handed out by the arena
+    std::size_t bytesUsed = 0;     // Bytes handed out, including alignment padding
+    std::size_t bytesReserved = 0; // Bytes obtained from the heap in blocks
+    std::size_t blocks = 0;        // Number of heap blocks backing the arena
+};
+
+/**
+ * Bump-pointer arena that carves small objects and strings out of large heap blocks.
+ * Allocation is a pointer increment and everything is released at once when the arena is destroyed,
+ * so objects placed in it must be trivially destructible.
+ */
+class NodeArena
+{
+public:
+    NodeArena();  // Constructor to initialize an empty arena
+    ~NodeArena(); // Destructor releasing every block in one pass
+
+    /**
+     * Allocates uninitialized storage from the current block, starting a new block when it is exhausted.
+     * @param bytes The number of bytes requested.
+     * @param alignment The required alignment, a power of two.
+     * @return A pointer to the storage, valid for the lifetime of the arena.
+     */
+    void *allocate(std::size_t bytes, std::size_t alignment)
+    {
+        std::size_t padding = (alignment - reinterpret_cast<std::size_t>(cursor) % alignment) % alignment;
+        if (cursor == nullptr || static_cast<std::size_t>(limit - cursor) < bytes + padding)
+        {
+            return allocateSlow(bytes, alignment);
+        }
+        char *result = cursor + padding;
+        cursor = result + bytes;
+        stats.allocations++;
+        stats.bytesUsed += bytes + padding;
+        return result;
+    }
+
+    /**
+     * Copies a string into the arena.
+     * @param text The characters to copy.
+     * @return A view of the arena-owned copy.
+     */
+    std::string_view intern(std::string_view text);
+
+    /**
+     * Releases every block and resets the usage totals, so the arena can be refilled from scratch.
+     * All storage handed out so far becomes invalid.
+     */
+    void clear();
+
+    /**
+     * Returns the usage totals accumulated so far.
+     */
+    const ArenaStats &getStats() const { return stats; }
+
+private:
+    std::vector<char *> blockList; // Heap blocks owned by the arena
+    char *cursor;                  // Next free byte in the current block
+    char *limit;                   // One past the last byte of the current block
+    std::size_t nextBlockSize;     // Size of the next block to request, grows geometrically
+    ArenaStats stats;              // Usage totals
+
+    NodeArena(const NodeArena &) = delete;            // Blocks are owned, copying is not supported
+    NodeArena &operator=(const NodeArena &) = delete; // Blocks are owned, copying is not supported
+
+    /**
+     * Starts a new block large enough for the request and allocates from it.
+     * @param bytes The number of bytes requested.
+     * @param alignment The required alignment, a power of two.
+     * @return A pointer to the storage.
+     */
+    void *allocateSlow(std::size_t bytes, std::size_t alignment);
+};
+
+#endif // TEXTANALYSISARENA_H
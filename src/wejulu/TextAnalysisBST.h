@@ -2,87 +2,220 @@
 #ifndef TEXTANALYSISBST_H
 #define TEXTANALYSISBST_H
 
+#include "TextAnalysisArena.h"
+#include "TextAnalysisCounter.h"
 #include <string>
+#include <string_view>
+#include <vector>
+
+// Default balancing strategy, overridable at build time (see TEXTANALYSIS_BALANCED in CMakeLists.txt)
+#ifndef TEXTANALYSIS_DEFAULT_BALANCE
+#define TEXTANALYSIS_DEFAULT_BALANCE BalanceMode::None
+#endif
+
+/**
+ * Strategy used by WordBST to keep its shape under control while inserting.
+ * None reproduces the classic unbalanced BST; AVL rebalances with rotations so that the height
+ * stays O(log n) even when words arrive in sorted order; Splay moves every inserted or repeated word
+ * to the root, so frequently seen words stay near the top.
+ */
+enum class BalanceMode
+{
+    None, // Plain BST insertion, shape depends on arrival order
+    AVL,  // Height-balanced AVL tree
+    Splay // Self-adjusting splay tree, amortized O(log n) per insertion
+};
 
 // Define the structure of a BST node
 struct Node
 {
-    std::string word; // Word stored in the node
-    int frequency;    // Frequency of the word
-    int level;        // The level of the node in the BST
-    Node *left;       // Pointer to the left child
-    Node *right;      // Pointer to the right child
+    std::string_view word; // Word stored in the node, the characters live in the owning tree's arena
+    int frequency;         // Frequency of the word
+    int level;             // The level of the node in the BST, brought up to date by collectReport after rotations
+    int height;            // Height of the subtree rooted at this node (leaf = 1), used for AVL balancing
+    Node *left;            // Pointer to the left child
+    Node *right;           // Pointer to the right child
 
     /**
      * Constructor to initialize a node with a word.
-     * @param word The word to store in the node.
+     * @param word The word to store in the node, which must outlive the node.
      */
-    Node(std::string word) : word(word), frequency(1), level(0), left(nullptr), right(nullptr) {}
+    Node(std::string_view word) : word(word), frequency(1), level(0), height(1), left(nullptr), right(nullptr) {}
 };
 
 /**
  * Class representing a binary search tree (BST) for storing and analyzing words from text files.
  * Allows for insertion of words, computation of probes for finding words, and writing the analysis results to a file.
+ * The position reported after each word's frequency is its level in the tree (root = 0).
  */
-class WordBST
+class WordBST : public WordCounter
 {
 public:
-    WordBST();  // Constructor to initialize the BST
-    ~WordBST(); // Destructor to clean up allocated resources and prevent memory leaks
-
     /**
-     * Inserts a word into the BST. If the word already exists, its frequency is incremented.
-     * @param word The word to insert into the BST.
+     * Constructor to initialize the BST.
+     * @param mode The balancing strategy applied on insertion (defaults to the build-time choice).
      */
-    void insert(const std::string &word); // Insert a word into the BST
+    explicit WordBST(BalanceMode mode = TEXTANALYSIS_DEFAULT_BALANCE);
+    ~WordBST() override; // Destructor releasing the node and word arenas in one go
 
     /**
-     * Writes the contents of the BST (words and their frequencies) to a specified file.
-     * The output includes the word, its frequency, and its level in the BST.
-     * @param fileName The name of the file to which the BST contents will be written.
+     * Inserts a word into the BST. If the word already exists, its frequency is incremented.
+     * @param word The word to insert into the BST.
      */
-    void writeToFile(const std::string &fileName); // Write the contents of the BST to a file
+    void insert(std::string_view word) override; // Insert a word into the BST
 
     /**
      * Computes the maximum and average number of probes required to find each word in the BST.
      * @param maxProbes A reference to an integer that will store the maximum number of probes encountered.
      * @param averageProbes A reference to a float that will store the average number of probes encountered.
      */
-    void computeProbes(int &maxProbes, float &averageProbes); // Compute maximum and average probes
+    void computeProbes(int &maxProbes, float &averageProbes) override; // Compute maximum and average probes
+
+    /**
+     * Computes the average number of probes weighted by each word's frequency, i.e. the expected number of
+     * nodes visited when looking up a word drawn at random from the file's text.
+     * @return The weighted average, or 0 for an empty tree.
+     */
+    float computeWeightedProbes() override;
+
+    /**
+     * Rebuilds the tree so that the frequency-weighted average number of probes is as small as possible. For up
+     * to exactOptimalLimit distinct words the tree is the exact optimal BST (Knuth's O(n^2) dynamic program); larger
+     * vocabularies use Mehlhorn's weight-balanced rule, which makes the root of every range the word splitting its
+     * total frequency in half and stays within a small constant of the optimum. The existing nodes are relinked, so
+     * no memory is allocated for nodes. Later insertions follow the tree's balance mode and may undo the layout.
+     */
+    void optimizeForLookups() override;
+
+    /**
+     * Appends every word of the BST with its frequency, in alphabetical order.
+     * The collected words point into this tree and stay valid for as long as the tree exists.
+     * @param out The vector receiving the words.
+     */
+    void collectInOrder(std::vector<WordCount> &out) const override;
+
+    /**
+     * Collects the report lines (words with their frequencies and levels, alphabetically) and the probe
+     * statistics, bringing the stored levels up to date after rotations; writeReport renders them.
+     * @param entries The vector receiving the report lines.
+     * @param statistics Receives the probe statistics.
+     */
+    void collectReport(std::vector<ReportEntry> &entries, ProbeStatistics &statistics) override;
+
+    /**
+     * Visits the report lines (words with their frequencies and levels, alphabetically), bringing the stored levels
+     * up to date like collectReport.
+     * @param visit Called with each word, its frequency and its level.
+     */
+    void visitReportLines(const ReportLineVisitor &visit) override;
+
+    /**
+     * Fills an empty BST from words that are already sorted and distinct, producing a perfectly balanced tree:
+     * the middle word of every range becomes the root of that range's subtree. Levels and probe statistics then
+     * describe this balanced shape, which depends only on the set of words and not on their arrival order.
+     * @param sortedWords Distinct words in alphabetical order with their frequencies; the words are copied.
+     */
+    void buildFromSorted(const std::vector<WordCount> &sortedWords) override;
+
+    /**
+     * Returns the number of distinct words counted.
+     */
+    std::size_t distinctWords() const override;
+
+    /**
+     * Returns the combined usage of the node pool and the word storage, for memory reporting.
+     */
+    ArenaStats getArenaStats() const override;
+
+    /**
+     * Reports the word comparisons, node allocations and deepest level reached by the insertions so far.
+     * @param stats Receives the counters.
+     * @return true in instrumented builds, false otherwise.
+     */
+    bool getInsertStats(InsertStats &stats) const override;
+
+    static constexpr std::size_t exactOptimalLimit = 1000; // Largest vocabulary rebuilt with the exact O(n^2) program
 
 private:
-    Node *root; // Root of the BST
+    Node *root;                // Root of the BST
+    BalanceMode mode;          // Balancing strategy applied on insertion
+    NodeArena nodePool;        // Storage for the nodes, kept separate from the words so nodes stay densely packed
+    NodeArena words;           // Storage for the characters of every distinct word
+    std::vector<Node **> path; // Links followed by the current AVL insertion, kept to avoid reallocating per word
+    Node *smallest;            // Unbalanced mode: the alphabetically first node, at the end of the left spine
+    Node *largest;             // Unbalanced mode: the alphabetically last node, at the end of the right spine
+    Node *appended;            // Unbalanced mode: the last new node if it went to the end of a spine, else nullptr
+#if TEXTANALYSIS_STATS
+    InsertStats insertStats;   // Work done by the insertions, for --stats
+#endif
+
+    WordBST(const WordBST &) = delete;            // The tree owns its nodes, copying is not supported
+    WordBST &operator=(const WordBST &) = delete; // The tree owns its nodes, copying is not supported
 
     /**
-     * Private helper function for recursive insertion of words into the BST.
-     * @param node The current node being examined or inserted into.
+     * Visits every node in alphabetical order without recursion. Pending ancestors are kept on an explicit
+     * stack on the heap, so even the degenerate chain built from sorted input cannot overflow the call stack.
+     * @param visit Called with each node and its level (root = 0).
+     */
+    template <typename Visitor>
+    void visitInOrder(Visitor visit) const;
+
+    /**
+     * Finds the ends of the left and right spines again after the tree has been relinked or rebuilt.
+     */
+    void resetSpineEnds();
+
+    /**
+     * Restores the AVL invariant at a node after one of its subtrees has grown, using single or double rotations.
+     * @param node The subtree root to rebalance; updated to the new subtree root.
+     */
+    void rebalance(Node *&node);
+
+    /**
+     * Splays a word towards the root of a subtree (top-down, Sleator and Tarjan): afterwards the root is the word
+     * itself if present, otherwise the last node met while searching for it.
+     * @param node The root of a non-empty subtree.
+     * @param word The word to splay towards the root.
+     * @return The new root of the subtree.
+     */
+    Node *splay(Node *node, std::string_view word);
+
+    /**
+     * Inserts a word in Splay mode, leaving the word's node at the root.
      * @param word The word to insert.
-     * @param currentLevel The current level in the BST, used for setting the level of inserted nodes.
      */
-    void insertPrivate(Node *&node, const std::string &word, int currentLevel);
+    void insertSplay(std::string_view word);
+
+    /**
+     * Relinks nodes, given in alphabetical order, into the tree chosen by a root selection rule.
+     * @param nodes The nodes in alphabetical order.
+     * @param chooseRoot Returns the index of the root for the index range [first, last).
+     */
+    template <typename RootChooser>
+    void relink(const std::vector<Node *> &nodes, RootChooser chooseRoot);
 
     /**
-     * Recursively deallocates memory used by the BST, preventing memory leaks.
-     * @param node The current node to destroy.
+     * Rotates a subtree to the left, lifting its right child into the subtree root position.
+     * @param node The subtree root to rotate; updated to the new subtree root.
      */
-    void destroyTree(Node *node);
+    void rotateLeft(Node *&node);
 
     /**
-     * Recursively writes the words stored in the BST in-order to a file, along with their frequency and level.
-     * @param node The current node being written to the file.
-     * @param outFile The output file stream to which the words are written.
+     * Rotates a subtree to the right, lifting its left child into the subtree root position.
+     * @param node The subtree root to rotate; updated to the new subtree root.
      */
-    void writeInOrder(Node *node, std::ofstream &outFile);
+    void rotateRight(Node *&node);
 
     /**
-     * Private helper function to recursively compute the total and maximum probes required to find each word.
-     * @param node The current node being examined.
-     * @param totalProbes A reference to an integer accumulating the total number of probes.
-     * @param maxProbes A reference to an integer storing the maximum number of probes encountered.
-     * @param wordCount A reference to an integer counting the number of words processed.
-     * @param currentProbe The current probe count for a given word.
+     * Recursively builds a balanced subtree from a range of sorted words.
+     * @param sortedWords The sorted, distinct words.
+     * @param first The index of the first word of the range.
+     * @param last The index one past the last word of the range.
+     * @param currentLevel The level of the subtree root.
+     * @return The root of the subtree, or nullptr for an empty range.
      */
-    void computeProbesPrivate(Node *node, int &totalProbes, int &maxProbes, int &wordCount, int currentProbe);
+    Node *buildBalancedPrivate(const std::vector<WordCount> &sortedWords, std::size_t first, std::size_t last,
+                               int currentLevel);
 };
 
 #endif // TEXTANALYSISBST_H
\ No newline at end of file
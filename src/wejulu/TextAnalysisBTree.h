@@ -0,0 +1,156 @@
+// TextAnalysisBTree.h
+#ifndef TEXTANALYSISBTREE_H
+#define TEXTANALYSISBTREE_H
+
+#include "TextAnalysisArena.h"
+#include "TextAnalysisCounter.h"
+#include <cstdint>
+#include <string_view>
+#include <vector>
+
+// Maximum number of words in a B-tree node; a node has up to one more child than words
+static const std::size_t btreeNodeKeys = 31;
+
+// Child index marking the absence of a child (leaves have none)
+static const std::uint32_t btreeNoChild = 0xFFFFFFFFu;
+
+/**
+ * One node of the B-tree, a fixed-size record in a contiguous vector. Children are 32-bit indices into that
+ * vector rather than pointers. The first 8 bytes of every word, lowercased and packed big-endian, are kept
+ * inline as an integer, so comparing against a word is one integer comparison unless both words share those
+ * 8 bytes and are longer than that; only then is the word itself read from the arena.
+ */
+struct BTreeNode
+{
+    std::uint64_t prefix[btreeNodeKeys];    // Packed lowercase first 8 bytes of each word, zero padded
+    std::uint32_t length[btreeNodeKeys];    // Length of each word in bytes
+    std::int32_t frequency[btreeNodeKeys];  // Frequency of each word
+    const char *text[btreeNodeKeys];        // Characters of each word, in the counter's arena
+    std::uint32_t child[btreeNodeKeys + 1]; // Child subtrees, btreeNoChild in a leaf
+    std::uint32_t count;                    // Number of words in the node
+};
+
+/**
+ * Word counting engine built on a B-tree of fixed-size nodes. Each node holds up to btreeNodeKeys words in
+ * alphabetical order, so the tree is a few levels deep even for millions of words and every level costs a
+ * handful of cache lines instead of one miss per comparison as in the WordBST.
+ *
+ * Probe statistics describe node visits: the number of probes for a word is the number of nodes a lookup
+ * visits, from the root down to the node holding the word. The position reported after each word's frequency
+ * is the depth of that node (root = 0), matching the BST convention where a word at level L takes L + 1 probes.
+ */
+class BTreeWordCounter : public WordCounter
+{
+public:
+    BTreeWordCounter();           // Constructor to initialize an empty tree
+    ~BTreeWordCounter() override; // Destructor releasing the node vector and the word arena
+
+    /**
+     * Counts one occurrence of a word, adding it to the tree if it is new.
+     * @param word The word, compared case-insensitively.
+     */
+    void insert(std::string_view word) override;
+
+    /**
+     * Computes the maximum and average number of node visits needed to find each word.
+     * @param maxProbes A reference to an integer that will store the maximum number of probes encountered.
+     * @param averageProbes A reference to a float that will store the average number of probes encountered.
+     */
+    void computeProbes(int &maxProbes, float &averageProbes) override;
+
+    /**
+     * Computes the average number of node visits weighted by each word's frequency.
+     * @return The weighted average, or 0 for an empty tree.
+     */
+    float computeWeightedProbes() override;
+
+    /**
+     * Appends every word with its frequency, in alphabetical order. The words point into the tree's arena.
+     * @param out The vector receiving the words.
+     */
+    void collectInOrder(std::vector<WordCount> &out) const override;
+
+    /**
+     * Collects the report lines (words with their frequencies and node depths, alphabetically) and the probe
+     * statistics.
+     * @param entries The vector receiving the report lines.
+     * @param statistics Receives the probe statistics.
+     */
+    void collectReport(std::vector<ReportEntry> &entries, ProbeStatistics &statistics) override;
+
+    /**
+     * Visits the report lines (words with their frequencies and node depths, alphabetically).
+     * @param visit Called with each word, its frequency and its node's depth.
+     */
+    void visitReportLines(const ReportLineVisitor &visit) override;
+
+    /**
+     * Fills an empty tree from distinct words with their frequencies.
+     * @param sortedWords The words to add; the words are copied.
+     */
+    void buildFromSorted(const std::vector<WordCount> &sortedWords) override;
+
+    /**
+     * Returns the number of distinct words counted.
+     */
+    std::size_t distinctWords() const override;
+
+    /**
+     * Returns the usage of the word arena plus the node vector, for memory reporting.
+     */
+    ArenaStats getArenaStats() const override;
+
+private:
+    // A word on its way into a node, with the child that follows it
+    struct PendingKey
+    {
+        std::uint64_t prefix;
+        std::uint32_t length;
+        std::int32_t frequency;
+        const char *text;
+        std::uint32_t rightChild;
+    };
+
+    // A node on the current insertion path and the slot the search stopped at
+    struct PathStep
+    {
+        std::uint32_t node;
+        std::uint32_t slot;
+    };
+
+    std::vector<BTreeNode> nodes; // Every node of the tree, addressed by index
+    std::uint32_t root;           // Index of the root node, btreeNoChild while the tree is empty
+    std::size_t wordCount;        // Number of distinct words
+    NodeArena words;              // Storage for the characters of every distinct word
+    std::vector<PathStep> path;   // Nodes visited by the current insertion, kept to avoid reallocating per word
+
+    BTreeWordCounter(const BTreeWordCounter &) = delete;            // The tree owns its words, copying is not supported
+    BTreeWordCounter &operator=(const BTreeWordCounter &) = delete; // The tree owns its words, copying is not supported
+
+    /**
+     * Adds occurrences of a word, inserting it if it is new.
+     * @param word The word to count.
+     * @param frequency The number of occurrences to add.
+     */
+    void add(std::string_view word, int frequency);
+
+    /**
+     * Inserts a word into the node at the end of the insertion path, splitting full nodes on the way back up.
+     * @param key The word to insert, with btreeNoChild as its right child.
+     */
+    void insertAlongPath(PendingKey key);
+
+    /**
+     * Allocates an empty node and returns its index.
+     */
+    std::uint32_t newNode();
+
+    /**
+     * Visits every word in alphabetical order without recursion.
+     * @param visit Called with the node, the word's slot in it and the node's depth (root = 0).
+     */
+    template <typename Visitor>
+    void visitInOrder(Visitor visit) const;
+};
+
+#endif // TEXTANALYSISBTREE_H
@@ -0,0 +1,702 @@
+/**
+ * @file TextAnalysisBench.cpp
+ * .............................Program Functionality...........................................
+ *
+ * Benchmark suite for the word counting pipeline. The program generates a set of synthetic corpora in memory from a
+ * fixed seed, so every run on every machine measures exactly the same text, and times each stage of the pipeline on
+ * its own:
+ *   - tokenize:      splitting the text into lowercased words with the Tokenizer (tokens/s and MB/s);
+ *   - insert:        counting the words in a fresh engine, one insert call per word (ns/insert);
+ *   - computeProbes: the maximum and average number of probes over the finished engine (the probe depth);
+ *   - writeToFile:   appending the report to a scratch file.
+ * Each stage is run --repeat times and the fastest run is reported, which filters out most of the noise caused by
+ * other processes. Every corpus is generated and measured in a child process of its own, so that its peak resident
+ * set size (peakRssKiB, read from the child's resource usage when it exits) is not the high-water mark left by an
+ * earlier, larger corpus. The words replayed into the engines are held in memory for the whole run, so the JSON also
+ * gives engineRssKiB: how far the insert and report stages raised the peak above the text and those words.
+ *
+ * Results are written as one JSON document, so that runs of different releases can be compared by a script.
+ */
+
+/**
+ *...............................Corpora.......................................
+ *
+ * Every corpus draws its words from a vocabulary of pronounceable pseudo-words (--vocabulary of them):
+ *   sorted       every word of the vocabulary in alphabetical order, each repeated for an equal share of the text;
+ *   reverse      the same in reverse alphabetical order;
+ *   uniform      words drawn uniformly at random;
+ *   zipf         words drawn from a Zipf distribution with exponent --zipf-skew, like natural text;
+ *   hyphenated   long compounds of 3 to 8 vocabulary words joined by hyphens, Zipf distributed;
+ *   possessive   Zipf distributed words, most of them followed by 's and a third of them capitalized.
+ * Words are separated by spaces and punctuation, with a line break every 12 words.
+ *
+ * Options:
+ *   --words N            Number of words in each corpus. Defaults to 1000000.
+ *   --vocabulary N       Number of distinct vocabulary words. Defaults to 50000.
+ *   --zipf-skew S        Exponent of the Zipf distribution. Defaults to 1.0.
+ *   --seed N             Seed of the generator. Defaults to 1.
+ *   --repeat N           Runs of every stage; the fastest is reported. Defaults to 3.
+ *   --corpus NAME        Benchmark only the named corpus (may be given several times). Defaults to all of them.
+ *   --engine bst|hash|btree|radix
+ *                        Counting engine under test. Defaults to 'bst'.
+ *   --balance none|avl|splay
+ *                        Balancing strategy of the 'bst' engine. Defaults to 'avl', because the sorted corpora turn an
+ *                        unbalanced tree into a list and take quadratic time.
+ *   --output FILE        Where the JSON results are written. Defaults to standard output.
+ *   --scratch FILE       File the writeToFile stage appends to; removed afterwards. Defaults to
+ *                        'TextAnalysisBench.scratch' in the current directory.
+ *   --write-corpus DIR   Also save every corpus as DIR/<name>.txt and list them in DIR/input.txt, so that the same text
+ *                        can be fed to TextAnalysis.
+ */
+
+// necessary header files
+#include "TextAnalysisBST.h"
+#include "TextAnalysisBTree.h"
+#include "TextAnalysisHash.h"
+#include "TextAnalysisRadix.h"
+#include "TextAnalysisTokenizer.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <sys/resource.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+// Command line options of the benchmark
+struct BenchOptions
+{
+    std::size_t words = 1000000;                           // Words in each corpus
+    std::size_t vocabulary = 50000;                        // Distinct vocabulary words
+    double zipfSkew = 1.0;                                 // Exponent of the Zipf distribution
+    std::uint64_t seed = 1;                                // Seed of the generator
+    unsigned repeat = 3;                                   // Runs of every stage
+    std::vector<std::string> corpora;                      // Corpora to benchmark (empty = all)
+    std::string engine = "bst";                            // Counting engine under test
+    BalanceMode balance = BalanceMode::AVL;                // Balancing strategy of the bst engine
+    std::string outputFile;                                // Destination of the JSON results (empty = stdout)
+    std::string scratchFile = "TextAnalysisBench.scratch"; // File written by the writeToFile stage
+    std::string corpusDirectory;                           // Where the corpora are saved (empty = not saved)
+};
+
+// Names of the corpora, in the order they are benchmarked
+static const char *const corpusNames[] = {"sorted", "reverse", "uniform", "zipf", "hyphenated", "possessive"};
+
+/**
+ * Small deterministic pseudo-random generator (SplitMix64). The standard distributions are not specified exactly
+ * and differ between library implementations, so the corpora are drawn with this generator alone.
+ */
+class BenchRandom
+{
+public:
+    explicit BenchRandom(std::uint64_t seed) : state(seed) {}
+
+    // Returns the next 64 random bits
+    std::uint64_t next()
+    {
+        std::uint64_t z = (state += 0x9E3779B97F4A7C15ULL);
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+        return z ^ (z >> 31);
+    }
+
+    // Returns a number in [0, bound)
+    std::size_t below(std::size_t bound) { return static_cast<std::size_t>(next() % bound); }
+
+    // Returns a number in [0, 1)
+    double unit() { return static_cast<double>(next() >> 11) * (1.0 / 9007199254740992.0); }
+
+private:
+    std::uint64_t state; // Generator state
+};
+
+/**
+ * Draws vocabulary ranks from a Zipf distribution by binary search over its cumulative weights.
+ */
+class ZipfSampler
+{
+public:
+    /**
+     * Constructor precomputing the cumulative weights.
+     * @param size The number of ranks.
+     * @param skew The exponent; rank r has weight 1 / (r + 1)^skew.
+     */
+    ZipfSampler(std::size_t size, double skew) : cumulative(size)
+    {
+        double total = 0;
+        for (std::size_t rank = 0; rank < size; rank++)
+        {
+            total += 1.0 / std::pow(static_cast<double>(rank + 1), skew);
+            cumulative[rank] = total;
+        }
+    }
+
+    // Returns a rank, 0 being the most frequent
+    std::size_t sample(BenchRandom &random) const
+    {
+        double target = random.unit() * cumulative.back();
+        std::size_t rank = std::upper_bound(cumulative.begin(), cumulative.end(), target) - cumulative.begin();
+        return rank < cumulative.size() ? rank : cumulative.size() - 1;
+    }
+
+private:
+    std::vector<double> cumulative; // Sum of the weights of ranks 0..r
+};
+
+/**
+ * Builds a vocabulary of distinct pronounceable lowercase words (consonant-vowel syllables ending in a digit), in a
+ * shuffled order so that a word's Zipf rank does not depend on its spelling.
+ *
+ * @param size The number of words.
+ * @param random The generator.
+ * @return The words.
+ */
+std::vector<std::string> makeVocabulary(std::size_t size, BenchRandom &random)
+{
+    static const char consonants[] = "bcdfghjklmnprstvwz";
+    static const char vowels[] = "aeiou";
+    std::vector<std::string> words;
+    words.reserve(size);
+    for (std::size_t index = 0; index < size; index++)
+    {
+        // The index is spelled in base 90 (consonant-vowel syllables), so the words are distinct; random syllables
+        // in front vary their lengths and first letters
+        std::string word;
+        std::size_t extra = random.below(3);
+        for (std::size_t i = 0; i < extra; i++)
+        {
+            word += consonants[random.below(sizeof(consonants) - 1)];
+            word += vowels[random.below(sizeof(vowels) - 1)];
+        }
+        std::size_t rest = index;
+        do
+        {
+            word += consonants[rest % (sizeof(consonants) - 1)];
+            rest /= sizeof(consonants) - 1;
+            word += vowels[rest % (sizeof(vowels) - 1)];
+            rest /= sizeof(vowels) - 1;
+        } while (rest > 0);
+        word += std::to_string(extra); // Keeps words with different prefixes from colliding
+        words.push_back(word);
+    }
+    for (std::size_t i = size; i > 1; i--)
+    {
+        std::swap(words[i - 1], words[random.below(i)]);
+    }
+    return words;
+}
+
+/**
+ * Generates one corpus.
+ *
+ * @param name The corpus name (see the header comment).
+ * @param vocabulary The vocabulary, in shuffled order.
+ * @param options The benchmark options.
+ * @return The text of the corpus.
+ */
+std::string makeCorpus(const std::string &name, const std::vector<std::string> &vocabulary, const BenchOptions &options)
+{
+    static const char *const separators[] = {" ", " ", " ", " ", ", ", ". ", "; ", " (", ") ", "! "};
+    BenchRandom random(options.seed * 0x100000001B3ULL + name.size() * 31 + static_cast<unsigned char>(name[0]));
+    ZipfSampler zipf(vocabulary.size(), options.zipfSkew);
+    std::vector<std::string> sorted;
+    if (name == "sorted" || name == "reverse")
+    {
+        sorted = vocabulary;
+        std::sort(sorted.begin(), sorted.end());
+        if (name == "reverse")
+        {
+            std::reverse(sorted.begin(), sorted.end());
+        }
+    }
+
+    std::string text;
+    std::string word;
+    for (std::size_t i = 0; i < options.words; i++)
+    {
+        if (!sorted.empty())
+        {
+            word = sorted[i * sorted.size() / options.words];
+        }
+        else if (name == "uniform")
+        {
+            word = vocabulary[random.below(vocabulary.size())];
+        }
+        else if (name == "hyphenated")
+        {
+            // The compound's parts are derived from its rank, so the same rank always spells the same compound
+            std::size_t rank = zipf.sample(random);
+            BenchRandom parts(rank + 1);
+            std::size_t count = 3 + parts.below(6);
+            word = vocabulary[rank];
+            for (std::size_t part = 1; part < count; part++)
+            {
+                word += '-';
+                word += vocabulary[parts.below(vocabulary.size())];
+            }
+        }
+        else
+        {
+            word = vocabulary[zipf.sample(random)];
+            if (name == "possessive")
+            {
+                if (random.below(3) == 0)
+                {
+                    word[0] = static_cast<char>(word[0] - 'a' + 'A');
+                }
+                if (random.below(4) != 0)
+                {
+                    word += "'s";
+                }
+            }
+        }
+        text += word;
+        text += (i + 1) % 12 == 0 ? "\n" : separators[random.below(sizeof(separators) / sizeof(separators[0]))];
+    }
+    return text;
+}
+
+/**
+ * Creates the engine under test.
+ *
+ * @param options The benchmark options.
+ * @return A new, empty counter.
+ */
+std::unique_ptr<WordCounter> createBenchCounter(const BenchOptions &options)
+{
+    if (options.engine == "hash")
+    {
+        return std::unique_ptr<WordCounter>(new HashWordCounter());
+    }
+    if (options.engine == "btree")
+    {
+        return std::unique_ptr<WordCounter>(new BTreeWordCounter());
+    }
+    if (options.engine == "radix")
+    {
+        return std::unique_ptr<WordCounter>(new RadixWordCounter());
+    }
+    return std::unique_ptr<WordCounter>(new WordBST(options.balance));
+}
+
+// Sink counting the words of the tokenize stage without keeping them
+class CountingTokenSink : public TokenSink
+{
+public:
+    void consumeToken(std::string_view word) override
+    {
+        tokens++;
+        characters += word.size();
+    }
+
+    std::size_t tokens = 0;     // Words seen
+    std::size_t characters = 0; // Total length of the words, so the loop cannot be optimized away
+};
+
+// Sink keeping every word, to replay them into the engines outside the timed tokenize stage
+class CollectingTokenSink : public TokenSink
+{
+public:
+    void consumeToken(std::string_view word) override
+    {
+        starts.push_back(text.size());
+        text.append(word.data(), word.size());
+    }
+
+    // Returns word i
+    std::string_view word(std::size_t i) const
+    {
+        std::size_t end = i + 1 < starts.size() ? starts[i + 1] : text.size();
+        return std::string_view(text).substr(starts[i], end - starts[i]);
+    }
+
+    std::string text;                // All words back to back
+    std::vector<std::size_t> starts; // Offset of every word in text
+};
+
+/**
+ * Feeds a text to a tokenizer in 1 MiB chunks, like successive windows of a mapped file.
+ *
+ * @param text The text.
+ * @param sink The receiver of the words.
+ */
+void tokenizeText(const std::string &text, TokenSink &sink)
+{
+    const std::size_t chunk = 1024 * 1024;
+    Tokenizer tokenizer(sink);
+    for (std::size_t offset = 0; offset < text.size(); offset += chunk)
+    {
+        tokenizer.feed(text.data() + offset, std::min(chunk, text.size() - offset));
+    }
+    tokenizer.finish();
+}
+
+// Returns the seconds elapsed since a start time
+static double secondsSince(std::chrono::steady_clock::time_point start)
+{
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+// Returns the peak resident set size of the process so far, in KiB
+static long peakResidentKiB()
+{
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    return usage.ru_maxrss;
+}
+
+// Returns a rate, or 0 when the duration was too short for the clock to measure (JSON has no infinity)
+static double perSecond(double amount, double seconds)
+{
+    return seconds > 0 ? amount / seconds : 0;
+}
+
+// Returns a file's size in bytes, or 0 if it does not exist
+static long long fileSize(const std::string &fileName)
+{
+    struct stat info;
+    return stat(fileName.c_str(), &info) == 0 ? static_cast<long long>(info.st_size) : 0;
+}
+
+/**
+ * Benchmarks every stage on one corpus and appends its JSON object to the results, all but the peakRssKiB member
+ * and the closing brace, which only the parent process can write (see measureCorpus).
+ *
+ * @param name The corpus name.
+ * @param text The corpus.
+ * @param options The benchmark options.
+ * @param json The stream receiving the JSON object.
+ */
+void benchmarkCorpus(const std::string &name, const std::string &text, const BenchOptions &options,
+                     std::ostream &json)
+{
+    double tokenizeSeconds = 1e30, insertSeconds = 1e30, probeSeconds = 1e30, writeSeconds = 1e30;
+    std::size_t tokens = 0, distinctWords = 0;
+    int maxProbes = 0;
+    float averageProbes = 0;
+    long long reportBytes = 0;
+
+    // The words are counted first so that the collecting sink grows its buffers once: reallocating them would leave
+    // a high-water mark that hides the engine's own memory
+    CountingTokenSink sizes;
+    tokenizeText(text, sizes);
+    CollectingTokenSink collected;
+    collected.text.reserve(sizes.characters);
+    collected.starts.reserve(sizes.tokens);
+    tokenizeText(text, collected);
+    long residentBeforeEngines = peakResidentKiB();
+    for (unsigned run = 0; run < options.repeat; run++)
+    {
+        CountingTokenSink sink;
+        auto start = std::chrono::steady_clock::now();
+        tokenizeText(text, sink);
+        tokenizeSeconds = std::min(tokenizeSeconds, secondsSince(start));
+        tokens = sink.tokens;
+
+        std::unique_ptr<WordCounter> counter = createBenchCounter(options);
+        start = std::chrono::steady_clock::now();
+        for (std::size_t i = 0; i < collected.starts.size(); i++)
+        {
+            counter->insert(collected.word(i));
+        }
+        insertSeconds = std::min(insertSeconds, secondsSince(start));
+        distinctWords = counter->distinctWords();
+
+        start = std::chrono::steady_clock::now();
+        counter->computeProbes(maxProbes, averageProbes);
+        probeSeconds = std::min(probeSeconds, secondsSince(start));
+
+        std::remove(options.scratchFile.c_str());
+        start = std::chrono::steady_clock::now();
+        counter->writeToFile(options.scratchFile);
+        writeSeconds = std::min(writeSeconds, secondsSince(start));
+        reportBytes = fileSize(options.scratchFile);
+        std::remove(options.scratchFile.c_str());
+    }
+
+    json << "    {\n"
+         << "      \"name\": \"" << name << "\",\n"
+         << "      \"bytes\": " << text.size() << ",\n"
+         << "      \"tokens\": " << tokens << ",\n"
+         << "      \"distinctWords\": " << distinctWords << ",\n"
+         << "      \"tokenize\": {\"seconds\": " << tokenizeSeconds
+         << ", \"tokensPerSecond\": " << perSecond(static_cast<double>(tokens), tokenizeSeconds)
+         << ", \"megabytesPerSecond\": " << perSecond(text.size() / 1e6, tokenizeSeconds) << "},\n"
+         << "      \"insert\": {\"seconds\": " << insertSeconds
+         << ", \"nsPerInsert\": " << (tokens == 0 ? 0 : insertSeconds * 1e9 / tokens) << "},\n"
+         << "      \"computeProbes\": {\"seconds\": " << probeSeconds << ", \"maxProbes\": " << maxProbes
+         << ", \"averageProbes\": " << averageProbes << "},\n"
+         << "      \"writeToFile\": {\"seconds\": " << writeSeconds << ", \"bytes\": " << reportBytes << "},\n"
+         << "      \"engineRssKiB\": " << peakResidentKiB() - residentBeforeEngines << ",\n";
+}
+
+/**
+ * Generates one corpus and benchmarks it in a child process, then appends its JSON object to the results with the
+ * child's peak resident set size.
+ *
+ * @param name The corpus name.
+ * @param vocabulary The vocabulary, in shuffled order.
+ * @param options The benchmark options.
+ * @param json The stream receiving the JSON object.
+ * @return true on success, false if the child could not be started or failed.
+ */
+bool measureCorpus(const std::string &name, const std::vector<std::string> &vocabulary, const BenchOptions &options,
+                   std::ostream &json)
+{
+    int results[2];
+    if (pipe(results) != 0)
+    {
+        std::perror("pipe");
+        return false;
+    }
+    pid_t child = fork();
+    if (child < 0)
+    {
+        std::perror("fork");
+        close(results[0]);
+        close(results[1]);
+        return false;
+    }
+    if (child == 0)
+    {
+        // The child sends its part of the JSON object through the pipe and leaves with _exit, so that it never
+        // flushes buffers inherited from the parent
+        close(results[0]);
+        std::string text = makeCorpus(name, vocabulary, options);
+        if (!options.corpusDirectory.empty())
+        {
+            std::ofstream(options.corpusDirectory + "/" + name + ".txt", std::ios::binary) << text;
+        }
+        std::cerr << "Benchmarking " << name << " (" << text.size() << " bytes)" << std::endl;
+        std::ostringstream object;
+        benchmarkCorpus(name, text, options, object);
+        std::string bytes = object.str();
+        for (std::size_t sent = 0; sent < bytes.size();)
+        {
+            ssize_t written = write(results[1], bytes.data() + sent, bytes.size() - sent);
+            if (written <= 0)
+            {
+                _exit(1);
+            }
+            sent += static_cast<std::size_t>(written);
+        }
+        _exit(0);
+    }
+
+    close(results[1]);
+    std::string object;
+    char buffer[4096];
+    ssize_t received;
+    while ((received = read(results[0], buffer, sizeof(buffer))) > 0)
+    {
+        object.append(buffer, static_cast<std::size_t>(received));
+    }
+    close(results[0]);
+
+    int status = 0;
+    struct rusage usage;
+    if (wait4(child, &status, 0, &usage) != child || !WIFEXITED(status) || WEXITSTATUS(status) != 0)
+    {
+        std::cerr << "Benchmark of " << name << " failed" << std::endl;
+        return false;
+    }
+    json << object << "      \"peakRssKiB\": " << usage.ru_maxrss << "\n"
+         << "    }";
+    return true;
+}
+
+/**
+ * Parses the command line into a BenchOptions structure.
+ *
+ * @param argc The argument count passed to main.
+ * @param argv The argument vector passed to main.
+ * @param options The options to fill in.
+ * @return true if every argument was recognized, false otherwise.
+ */
+bool parseBenchOptions(int argc, char *argv[], BenchOptions &options)
+{
+    for (int i = 1; i < argc; i++)
+    {
+        std::string arg = argv[i];
+        if (i + 1 >= argc)
+        {
+            std::cerr << "Missing value for " << arg << std::endl;
+            return false;
+        }
+        std::string value = argv[++i];
+        char *end = nullptr;
+        if (arg == "--words" || arg == "--vocabulary" || arg == "--seed" || arg == "--repeat")
+        {
+            unsigned long long number = std::strtoull(value.c_str(), &end, 10);
+            if (*end != '\0' || value.empty() || value[0] == '-' || (number == 0 && arg != "--seed"))
+            {
+                std::cerr << "Invalid value for " << arg << ": " << value << std::endl;
+                return false;
+            }
+            if (arg == "--words")
+            {
+                options.words = static_cast<std::size_t>(number);
+            }
+            else if (arg == "--vocabulary")
+            {
+                options.vocabulary = static_cast<std::size_t>(number);
+            }
+            else if (arg == "--seed")
+            {
+                options.seed = number;
+            }
+            else
+            {
+                options.repeat = static_cast<unsigned>(number);
+            }
+        }
+        else if (arg == "--zipf-skew")
+        {
+            options.zipfSkew = std::strtod(value.c_str(), &end);
+            if (*end != '\0' || value.empty() || !(options.zipfSkew >= 0))
+            {
+                std::cerr << "Invalid value for " << arg << ": " << value << std::endl;
+                return false;
+            }
+        }
+        else if (arg == "--corpus")
+        {
+            if (std::find(std::begin(corpusNames), std::end(corpusNames), value) == std::end(corpusNames))
+            {
+                std::cerr << "Unknown corpus: " << value << std::endl;
+                return false;
+            }
+            options.corpora.push_back(value);
+        }
+        else if (arg == "--engine")
+        {
+            if (value != "bst" && value != "hash" && value != "btree" && value != "radix")
+            {
+                std::cerr << "Unknown engine: " << value << std::endl;
+                return false;
+            }
+            options.engine = value;
+        }
+        else if (arg == "--balance")
+        {
+            if (value == "none")
+            {
+                options.balance = BalanceMode::None;
+            }
+            else if (value == "avl")
+            {
+                options.balance = BalanceMode::AVL;
+            }
+            else if (value == "splay")
+            {
+                options.balance = BalanceMode::Splay;
+            }
+            else
+            {
+                std::cerr << "Unknown balance mode: " << value << std::endl;
+                return false;
+            }
+        }
+        else if (arg == "--output")
+        {
+            options.outputFile = value;
+        }
+        else if (arg == "--scratch")
+        {
+            options.scratchFile = value;
+        }
+        else if (arg == "--write-corpus")
+        {
+            options.corpusDirectory = value;
+        }
+        else
+        {
+            std::cerr << "Unknown option: " << arg << std::endl;
+            return false;
+        }
+    }
+    return true;
+}
+
+// Returns the name of a balance mode as accepted by --balance
+static const char *balanceName(BalanceMode mode)
+{
+    return mode == BalanceMode::AVL ? "avl" : (mode == BalanceMode::Splay ? "splay" : "none");
+}
+
+// Main function: generates the corpora, benchmarks each of them and writes the JSON results
+int main(int argc, char *argv[])
+{
+    BenchOptions options;
+    if (!parseBenchOptions(argc, argv, options))
+    {
+        std::cerr << "Usage: " << argv[0] << " [--words N] [--vocabulary N] [--zipf-skew S] [--seed N] [--repeat N]"
+                  << " [--corpus NAME]... [--engine bst|hash|btree|radix] [--balance none|avl|splay]"
+                  << " [--output FILE] [--scratch FILE] [--write-corpus DIR]" << std::endl;
+        return -1;
+    }
+    if (options.corpora.empty())
+    {
+        options.corpora.assign(std::begin(corpusNames), std::end(corpusNames));
+    }
+    if (!options.corpusDirectory.empty())
+    {
+        mkdir(options.corpusDirectory.c_str(), 0755);
+    }
+
+    BenchRandom random(options.seed);
+    std::vector<std::string> vocabulary = makeVocabulary(options.vocabulary, random);
+
+    std::ostringstream json;
+    json << "{\n"
+         << "  \"benchmark\": \"TextAnalysisBench\",\n"
+         << "  \"parameters\": {\"words\": " << options.words << ", \"vocabulary\": " << options.vocabulary
+         << ", \"zipfSkew\": " << options.zipfSkew << ", \"seed\": " << options.seed
+         << ", \"repeat\": " << options.repeat << ", \"engine\": \"" << options.engine << "\", \"balance\": \""
+         << balanceName(options.balance) << "\", \"kernel\": \"" << tokenizerKernelName(activeTokenizerKernel())
+         << "\"},\n"
+         << "  \"corpora\": [\n";
+    std::ofstream inputList;
+    if (!options.corpusDirectory.empty())
+    {
+        inputList.open(options.corpusDirectory + "/input.txt");
+    }
+    for (std::size_t i = 0; i < options.corpora.size(); i++)
+    {
+        const std::string &name = options.corpora[i];
+        if (!options.corpusDirectory.empty())
+        {
+            inputList << options.corpusDirectory << "/" << name << ".txt\n"; // Written by the child
+        }
+        if (!measureCorpus(name, vocabulary, options, json))
+        {
+            return -1;
+        }
+        json << (i + 1 < options.corpora.size() ? ",\n" : "\n");
+    }
+    json << "  ]\n"
+         << "}\n";
+
+    if (options.outputFile.empty())
+    {
+        std::cout << json.str();
+        return 0;
+    }
+    std::ofstream output(options.outputFile);
+    output << json.str();
+    if (!output)
+    {
+        std::cerr << "Failed to write " << options.outputFile << std::endl;
+        return -1;
+    }
+    return 0; // on success
+}
@@ -0,0 +1,210 @@
+// TextAnalysisCounter.h
+#ifndef TEXTANALYSISCOUNTER_H
+#define TEXTANALYSISCOUNTER_H
+
+#include "TextAnalysisArena.h"
+#include "TextAnalysisReport.h"
+#include "TextAnalysisStats.h"
+#include <functional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// A distinct word and its number of occurrences, as exchanged when counters are merged
+struct WordCount
+{
+    std::string_view word; // The word, owned by the counter it was collected from
+    int frequency;         // Number of occurrences
+};
+
+// One line of a report: a word, its frequency and its engine-specific position (the number in parentheses)
+struct ReportEntry
+{
+    std::string_view word; // The word, owned by the counter it was collected from
+    int frequency;         // Number of occurrences
+    int position;          // Tree level or hash displacement, i.e. the probes needed to find the word minus one
+};
+
+// The probe statistics that open a report
+struct ProbeStatistics
+{
+    int maxProbes = 0;        // Maximum number of probes over all distinct words
+    float averageProbes = 0;  // Average number of probes over all distinct words
+    float weightedProbes = 0; // Average number of probes weighted by word frequency
+};
+
+// Receives one report line: the word (valid only during the call), its frequency and its position
+using ReportLineVisitor = std::function<void(std::string_view word, int frequency, int position)>;
+
+/**
+ * Common interface of the word counting engines (the WordBST and the hash table).
+ * An engine counts case-insensitive word occurrences and writes the report for one file: the maximum and
+ * average number of probes needed to find a word, then every distinct word in alphabetical order with its
+ * frequency and, in parentheses, its engine-specific position (see each engine for the exact meaning; it is
+ * always the number of probes for that word minus one).
+ */
+class WordCounter
+{
+public:
+    virtual ~WordCounter() {}
+
+    /**
+     * Counts one occurrence of a word.
+     * @param word The word, compared case-insensitively; the first spelling seen is the one reported.
+     */
+    virtual void insert(std::string_view word) = 0;
+
+    /**
+     * Computes the maximum and average number of probes required to find each word.
+     * @param maxProbes A reference to an integer that will store the maximum number of probes encountered.
+     * @param averageProbes A reference to a float that will store the average number of probes encountered.
+     */
+    virtual void computeProbes(int &maxProbes, float &averageProbes) = 0;
+
+    /**
+     * Computes the average number of probes weighted by each word's frequency, i.e. the expected cost of
+     * looking up a word drawn at random from the input text rather than from the list of distinct words.
+     * @return The weighted average, or 0 for an empty counter.
+     */
+    virtual float computeWeightedProbes() = 0;
+
+    /**
+     * Reorganizes the counter once all words have been counted so that frequent words take fewer probes to find.
+     * Engines without a tunable layout leave it unchanged.
+     */
+    virtual void optimizeForLookups() {}
+
+    /**
+     * Chooses whether reports include a "Weighted average number of probes" line after the average line.
+     * @param enabled true to include the line.
+     */
+    void setReportWeightedProbes(bool enabled) { reportWeighted = enabled; }
+
+    /**
+     * Appends the report (probe statistics, then every word with its frequency and position, then the
+     * separator line) to a buffer. The lines are streamed from visitReportLines, so nothing is collected.
+     * @param out The buffer receiving the report.
+     */
+    void writeReport(ReportBuffer &out);
+
+    /**
+     * Appends the report to a file, see writeReport.
+     * @param fileName The name of the file to which the report will be appended.
+     */
+    void writeToFile(const std::string &fileName);
+
+    /**
+     * Appends every distinct word with its frequency, in alphabetical order.
+     * The collected words point into this counter and stay valid while it exists and is not modified; engines
+     * that copy the words out (see RadixWordCounter) only keep them until their next collection.
+     * @param out The vector receiving the words.
+     */
+    virtual void collectInOrder(std::vector<WordCount> &out) const = 0;
+
+    /**
+     * Collects the content of the report without rendering it: every report line in alphabetical order and the
+     * probe statistics, exactly as writeReport would write them (including the weighted average, whether or not it
+     * is reported). The collected words stay valid as described for collectInOrder.
+     * @param entries The vector receiving the report lines.
+     * @param statistics Receives the probe statistics.
+     */
+    virtual void collectReport(std::vector<ReportEntry> &entries, ProbeStatistics &statistics) = 0;
+
+    /**
+     * Calls a function for every report line in alphabetical order, as collectReport would collect them, without
+     * storing the lines or copying the words.
+     * @param visit Called with each word (valid only during the call), its frequency and its position.
+     */
+    virtual void visitReportLines(const ReportLineVisitor &visit) = 0;
+
+    /**
+     * Fills an empty counter from words that are already sorted and distinct, as produced by mergeSortedRuns.
+     * @param sortedWords Distinct words in alphabetical order with their frequencies; the words are copied.
+     */
+    virtual void buildFromSorted(const std::vector<WordCount> &sortedWords) = 0;
+
+    /**
+     * Returns the number of distinct words counted, for memory reporting.
+     */
+    virtual std::size_t distinctWords() const = 0;
+
+    /**
+     * Returns the usage of the arenas holding the counter's words and nodes, for memory reporting.
+     */
+    virtual ArenaStats getArenaStats() const = 0;
+
+    /**
+     * Reports the work done by the insertions so far, for the --stats telemetry.
+     * @param stats Receives the comparisons, node allocations and peak depth.
+     * @return true if the engine gathers these counters in this build, false otherwise (stats is unchanged).
+     */
+    virtual bool getInsertStats(InsertStats & /*stats*/) const { return false; }
+
+protected:
+    bool reportWeighted = false; // Whether reports include the weighted average line
+};
+
+/**
+ * Appends the probe statistics lines that open every report.
+ *
+ * @param out The buffer receiving the report.
+ * @param statistics The statistics, averages are written with one decimal.
+ * @param weighted Whether to include the "Weighted average number of probes" line.
+ */
+void appendProbeStatistics(ReportBuffer &out, const ProbeStatistics &statistics, bool weighted);
+
+/**
+ * Appends one word line of a report: the word, its frequency and, in parentheses, its position.
+ *
+ * @param out The buffer receiving the line.
+ * @param word The word.
+ * @param frequency The number of occurrences.
+ * @param position The engine-specific position.
+ */
+void appendReportLine(ReportBuffer &out, std::string_view word, int frequency, int position);
+
+/**
+ * Renders a collected report: the probe statistics, every word line, then the separator line. It renders the
+ * lines the same way as WordCounter::writeReport, so collected and streamed reports share one format.
+ *
+ * @param out The buffer receiving the report.
+ * @param entries The report lines in alphabetical order, as collected by WordCounter::collectReport.
+ * @param statistics The probe statistics.
+ * @param weighted Whether to include the "Weighted average number of probes" line.
+ */
+void appendReport(ReportBuffer &out, const std::vector<ReportEntry> &entries, const ProbeStatistics &statistics,
+                  bool weighted);
+
+/**
+ * Lowercase mapping of every byte value, matching std::tolower in the "C" locale, without a function call per
+ * byte. compareIgnoreCase and the engines' hot paths all fold through it, so they always agree on the order.
+ */
+struct FoldTable
+{
+    unsigned char lower[256];
+
+    FoldTable(); // Constructor filling the table with the ASCII lowercase mapping
+};
+
+// The shared lowercase mapping used by the engines' hot paths
+extern const FoldTable foldTable;
+
+/**
+ * Compares two words case-insensitively without building lowercase copies. This is the order of every report.
+ *
+ * @param a The first word.
+ * @param b The second word.
+ * @return A negative value if a sorts before b, zero if they are equal, a positive value otherwise.
+ */
+int compareIgnoreCase(std::string_view a, std::string_view b);
+
+/**
+ * Merges several alphabetically sorted word runs into one, adding up the frequencies of words that appear
+ * in more than one run. When spellings differ only by case, the one from the earliest run is kept.
+ *
+ * @param runs The sorted runs, typically collected from counters built over consecutive parts of a file.
+ * @param merged The vector receiving the merged run.
+ */
+void mergeSortedRuns(const std::vector<std::vector<WordCount>> &runs, std::vector<WordCount> &merged);
+
+#endif // TEXTANALYSISCOUNTER_H
@@ -0,0 +1,138 @@
+// TextAnalysisHash.h
+#ifndef TEXTANALYSISHASH_H
+#define TEXTANALYSISHASH_H
+
+#include "TextAnalysisArena.h"
+#include "TextAnalysisCounter.h"
+#include <cstdint>
+#include <string_view>
+#include <vector>
+
+// Words up to this length are stored entirely inside their hash slot
+static const std::size_t inlineKeyLength = 16;
+
+/**
+ * One slot of the open-addressing table, two per cache line. Short words live inline in the slot; longer words
+ * keep their first 8 bytes inline (followed by a pointer to the full copy in the arena), so most mismatching
+ * keys are rejected by the cached hash or the inline bytes without touching another cache line.
+ */
+struct HashSlot
+{
+    std::uint64_t hash;        // Hash of the lowercased word, cached for fast rejection and rehashing
+    std::uint32_t length;      // Length of the word in bytes
+    std::int32_t frequency;    // Frequency of the word, 0 marks an empty slot
+    char key[inlineKeyLength]; // The word itself, or its first 8 bytes followed by a pointer to the arena copy
+};
+
+/**
+ * Word counting engine built on an open-addressing hash table with linear probing.
+ * Counting a word costs one hash and usually a single slot comparison regardless of the vocabulary size; the
+ * words are only sorted once, when the report is written.
+ *
+ * Probe statistics describe the table: the number of probes for a word is the number of slots a successful
+ * lookup inspects, from its home slot up to the slot holding it. The position reported after each word's
+ * frequency is that probe count minus one (its displacement from the home slot), matching the BST convention
+ * where a word at level L takes L + 1 probes.
+ */
+class HashWordCounter : public WordCounter
+{
+public:
+    HashWordCounter();           // Constructor to initialize an empty table
+    ~HashWordCounter() override; // Destructor releasing the table and the word arena
+
+    /**
+     * Counts one occurrence of a word, adding it to the table if it is new.
+     * @param word The word, compared case-insensitively.
+     */
+    void insert(std::string_view word) override;
+
+    /**
+     * Computes the maximum and average number of probes needed to find each word in the table.
+     * @param maxProbes A reference to an integer that will store the maximum number of probes encountered.
+     * @param averageProbes A reference to a float that will store the average number of probes encountered.
+     */
+    void computeProbes(int &maxProbes, float &averageProbes) override;
+
+    /**
+     * Computes the average number of probes weighted by each word's frequency.
+     * @return The weighted average, or 0 for an empty table.
+     */
+    float computeWeightedProbes() override;
+
+    /**
+     * Appends every word with its frequency, sorted alphabetically. The words may point into the table and stay
+     * valid until the next insertion.
+     * @param out The vector receiving the words.
+     */
+    void collectInOrder(std::vector<WordCount> &out) const override;
+
+    /**
+     * Collects the report lines (words with their frequencies and displacements, alphabetically) and the probe
+     * statistics. The words may point into the table and stay valid until the next insertion.
+     * @param entries The vector receiving the report lines.
+     * @param statistics Receives the probe statistics.
+     */
+    void collectReport(std::vector<ReportEntry> &entries, ProbeStatistics &statistics) override;
+
+    /**
+     * Visits the report lines (words with their frequencies and displacements, alphabetically).
+     * @param visit Called with each word, its frequency and its displacement.
+     */
+    void visitReportLines(const ReportLineVisitor &visit) override;
+
+    /**
+     * Fills an empty table from distinct words with their frequencies.
+     * @param sortedWords The words to add; the words are copied.
+     */
+    void buildFromSorted(const std::vector<WordCount> &sortedWords) override;
+
+    /**
+     * Returns the number of distinct words counted.
+     */
+    std::size_t distinctWords() const override;
+
+    /**
+     * Returns the usage of the word arena plus the slot array, for memory reporting.
+     */
+    ArenaStats getArenaStats() const override;
+
+private:
+    std::vector<HashSlot> slots; // The table, its size is always a power of two
+    std::size_t count;           // Number of occupied slots
+    NodeArena words;             // Storage for words too long to be stored inline
+
+    HashWordCounter(const HashWordCounter &) = delete;            // The table owns its words, copying is not supported
+    HashWordCounter &operator=(const HashWordCounter &) = delete; // The table owns its words, copying is not supported
+
+    /**
+     * Adds occurrences of a word, inserting it if it is new.
+     * @param word The word to count.
+     * @param frequency The number of occurrences to add.
+     */
+    void add(std::string_view word, int frequency);
+
+    /**
+     * Doubles the table and reinserts every word, keeping the load factor bounded.
+     */
+    void grow();
+
+    /**
+     * Returns the word stored in an occupied slot.
+     * @param slot The slot to read.
+     */
+    static std::string_view wordOf(const HashSlot &slot);
+
+    /**
+     * Returns the number of probes a successful lookup of the word in a slot takes.
+     * @param index The index of the occupied slot.
+     */
+    int probesAt(std::size_t index) const;
+
+    /**
+     * Lists the indices of the occupied slots in the alphabetical order of their words.
+     * @param order The vector receiving the indices.
+     */
+    void sortOccupied(std::vector<std::size_t> &order) const;
+};
+
+#endif // TEXTANALYSISHASH_H
@@ -0,0 +1,67 @@
+// TextAnalysisImplArena.cpp
+
+#include "TextAnalysisArena.h"
+#include <cstdlib>
+#include <cstring>
+#include <new>
+
+// Blocks start small so that tiny files stay cheap, then double up to the cap
+static const std::size_t initialBlockSize = 4 * 1024;
+static const std::size_t maximumBlockSize = 1024 * 1024;
+
+// Initialize an arena without any block, the first allocation requests one
+NodeArena::NodeArena() : cursor(nullptr), limit(nullptr), nextBlockSize(initialBlockSize) {}
+
+// Release every block at once, objects inside are never destroyed individually
+NodeArena::~NodeArena()
+{
+    clear();
+}
+
+// Documented in TextAnalysisArena.h
+void NodeArena::clear()
+{
+    for (char *block : blockList)
+    {
+        std::free(block);
+    }
+    blockList.clear();
+    cursor = nullptr;
+    limit = nullptr;
+    nextBlockSize = initialBlockSize;
+    stats = ArenaStats();
+}
+
+// Documented in TextAnalysisArena.h
+void *NodeArena::allocateSlow(std::size_t bytes, std::size_t alignment)
+{
+    std::size_t blockSize = nextBlockSize;
+    if (blockSize < bytes + alignment)
+    {
+        blockSize = bytes + alignment; // Oversized requests get a dedicated block
+    }
+    char *block = static_cast<char *>(std::malloc(blockSize));
+    if (block == nullptr)
+    {
+        throw std::bad_alloc();
+    }
+    blockList.push_back(block);
+    stats.blocks++;
+    stats.bytesReserved += blockSize;
+    if (nextBlockSize < maximumBlockSize)
+    {
+        nextBlockSize *= 2;
+    }
+
+    cursor = block;
+    limit = block + blockSize;
+    return allocate(bytes, alignment);
+}
+
+// Documented in TextAnalysisArena.h
+std::string_view NodeArena::intern(std::string_view text)
+{
+    char *copy = static_cast<char *>(allocate(text.size(), 1));
+    std::memcpy(copy, text.data(), text.size());
+    return std::string_view(copy, text.size());
+}
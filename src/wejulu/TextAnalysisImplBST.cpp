@@ -1,134 +1,545 @@
 // TextAnalysisImplBST.cpp
 
 #include "TextAnalysisBST.h"
-#include <fstream>
-#include <iostream>
-#include <cctype>
-#include <iomanip>
+#include <algorithm>
+#include <limits>
+#include <new>
+#include <utility>
+
+// Initialize the BST with a null root
+WordBST::WordBST(BalanceMode mode)
+    : root(nullptr), mode(mode), smallest(nullptr), largest(nullptr), appended(nullptr)
+{
+}
+
+#if TEXTANALYSIS_STATS
+// Records an insertion that compared the word against some nodes and stopped at the given depth
+static void recordInsertion(InsertStats &stats, int comparisons, int depth)
+{
+    stats.comparisons += static_cast<std::uint64_t>(comparisons);
+    stats.peakDepth = depth > stats.peakDepth ? depth : stats.peakDepth;
+}
+#endif
+
+// Height of a possibly empty subtree
+static int heightOf(const Node *node)
+{
+    return node == nullptr ? 0 : node->height;
+}
+
+// Recompute a node's height from its children
+static void updateHeight(Node *node)
+{
+    int leftHeight = heightOf(node->left);
+    int rightHeight = heightOf(node->right);
+    node->height = (leftHeight > rightHeight ? leftHeight : rightHeight) + 1;
+}
+
+// Nodes and words live in the arenas, which release their blocks when they are destroyed
+WordBST::~WordBST() {}
+
+// Documented in TextAnalysisBST.h
+void WordBST::rotateLeft(Node *&node)
+{
+    Node *pivot = node->right;
+    node->right = pivot->left;
+    pivot->left = node;
+    updateHeight(node);
+    updateHeight(pivot);
+    node = pivot; // Levels below this point are now out of date until collectReport refreshes them
+}
+
+// Documented in TextAnalysisBST.h
+void WordBST::rotateRight(Node *&node)
+{
+    Node *pivot = node->left;
+    node->left = pivot->right;
+    pivot->right = node;
+    updateHeight(node);
+    updateHeight(pivot);
+    node = pivot; // Levels below this point are now out of date until collectReport refreshes them
+}
 
 // Documented in TextAnalysisBST.h
-std::string toLowerCase(const std::string &str)
+void WordBST::rebalance(Node *&node)
 {
-    std::string lowerStr;
-    // Iterate through each character and convert it to lowercase
-    for (char c : str)
+    updateHeight(node);
+    int balance = heightOf(node->left) - heightOf(node->right);
+    if (balance > 1)
+    {
+        // Left-heavy: a left-right case needs the left child rotated first
+        if (heightOf(node->left->left) < heightOf(node->left->right))
+        {
+            rotateLeft(node->left);
+        }
+        rotateRight(node);
+    }
+    else if (balance < -1)
     {
-        lowerStr += std::tolower(static_cast<unsigned char>(c));
+        // Right-heavy: a right-left case needs the right child rotated first
+        if (heightOf(node->right->right) < heightOf(node->right->left))
+        {
+            rotateRight(node->right);
+        }
+        rotateLeft(node);
     }
-    return lowerStr;
 }
 
-// Initialize the BST with a null root
-WordBST::WordBST() : root(nullptr) {}
+// Documented in TextAnalysisBST.h
+template <typename Visitor>
+void WordBST::visitInOrder(Visitor visit) const
+{
+    // Pending ancestors with their levels; lives on the heap, so any tree shape is safe
+    std::vector<std::pair<Node *, int>> stack;
+    Node *node = root;
+    int level = 0;
+    while (node != nullptr || !stack.empty())
+    {
+        // Descend to the leftmost unvisited node, remembering the way back
+        while (node != nullptr)
+        {
+            stack.emplace_back(node, level);
+            node = node->left;
+            level++;
+        }
+        std::pair<Node *, int> current = stack.back();
+        stack.pop_back();
+        visit(current.first, current.second);
+        node = current.first->right;
+        level = current.second + 1;
+    }
+}
 
-// Ensure all nodes are deleted when the BST is destroyed
-WordBST::~WordBST()
+// Documented in TextAnalysisBST.h
+Node *WordBST::splay(Node *node, std::string_view word)
 {
-    destroyTree(root); // Recursively delete all nodes to avoid memory leaks
+    // Nodes smaller than the word collect in a left tree, larger ones in a right tree; the header's right and
+    // left links hold their roots, and leftMax/rightMin are the attachment points for the next node on each side
+    Node header{std::string_view()};
+    Node *leftMax = &header, *rightMin = &header;
+    TEXTANALYSIS_STAT(int comparisons = 0);
+    TEXTANALYSIS_STAT(int depth = 0); // Levels descended by the search
+    while (true)
+    {
+        int comparison = compareIgnoreCase(word, node->word);
+        TEXTANALYSIS_STAT(comparisons++);
+        if (comparison < 0)
+        {
+            if (node->left == nullptr)
+            {
+                break;
+            }
+            TEXTANALYSIS_STAT(comparisons++);
+            TEXTANALYSIS_STAT(depth++);
+            if (compareIgnoreCase(word, node->left->word) < 0)
+            {
+                // Zig-zig: rotate right before linking, which is what halves the depth of the search path
+                Node *child = node->left;
+                node->left = child->right;
+                child->right = node;
+                node = child;
+                if (node->left == nullptr)
+                {
+                    break;
+                }
+                TEXTANALYSIS_STAT(depth++);
+            }
+            rightMin->left = node;
+            rightMin = node;
+            node = node->left;
+        }
+        else if (comparison > 0)
+        {
+            if (node->right == nullptr)
+            {
+                break;
+            }
+            TEXTANALYSIS_STAT(comparisons++);
+            TEXTANALYSIS_STAT(depth++);
+            if (compareIgnoreCase(word, node->right->word) > 0)
+            {
+                Node *child = node->right;
+                node->right = child->left;
+                child->left = node;
+                node = child;
+                if (node->right == nullptr)
+                {
+                    break;
+                }
+                TEXTANALYSIS_STAT(depth++);
+            }
+            leftMax->right = node;
+            leftMax = node;
+            node = node->right;
+        }
+        else
+        {
+            break;
+        }
+    }
+    TEXTANALYSIS_STAT(recordInsertion(insertStats, comparisons, depth));
+    // Reassemble: the side trees become the children of the node that ended the search
+    leftMax->right = node->left;
+    rightMin->left = node->right;
+    node->left = header.right;
+    node->right = header.left;
+    return node;
 }
 
 // Documented in TextAnalysisBST.h
-void WordBST::destroyTree(Node *node)
+void WordBST::insertSplay(std::string_view word)
 {
-    if (node != nullptr)
+    if (root != nullptr)
     {
-        destroyTree(node->left);  // Delete left subtree
-        destroyTree(node->right); // Delete right subtree
-        delete node;              // Delete the current node
+        root = splay(root, word);
+        int comparison = compareIgnoreCase(word, root->word);
+        TEXTANALYSIS_STAT(insertStats.comparisons++);
+        if (comparison == 0)
+        {
+            root->frequency++;
+            return;
+        }
+        // The new word goes between the splayed root and its neighbour on the word's side
+        Node *node = new (nodePool.allocate(sizeof(Node), alignof(Node))) Node(words.intern(word));
+        if (comparison < 0)
+        {
+            node->left = root->left;
+            node->right = root;
+            root->left = nullptr;
+        }
+        else
+        {
+            node->right = root->right;
+            node->left = root;
+            root->right = nullptr;
+        }
+        root = node;
+        return;
     }
+    root = new (nodePool.allocate(sizeof(Node), alignof(Node))) Node(words.intern(word));
 }
 
 // Documented in TextAnalysisBST.h
-void WordBST::insertPrivate(Node *&node, const std::string &word, int currentLevel)
+void WordBST::insert(std::string_view word)
 {
-    if (node == nullptr)
+    if (mode == BalanceMode::Splay)
     {
-        // If spot is found, insert new node
-        node = new Node(word);
-        node->level = currentLevel;
+        insertSplay(word); // Levels change on every access, collectReport recomputes them
+        return;
     }
-    else if (toLowerCase(word) < toLowerCase(node->word))
+
+    // Walk down iteratively; for AVL, remember the links followed so the path can be rebalanced bottom-up
+    Node **link = &root;
+    int currentLevel = 0;
+    path.clear();
+    TEXTANALYSIS_STAT(int startLevel = 0);
+    TEXTANALYSIS_STAT(int hintComparisons = 0);
+    if (appended != nullptr)
     {
-        // Word should go to the left
-        insertPrivate(node->left, word, currentLevel + 1);
+        // Sorted input keeps extending one spine of the unbalanced tree, which would make every insertion walk the
+        // whole spine; while it does, the next word is tried at the same end first and attached there directly
+        int comparison = compareIgnoreCase(word, appended->word);
+        TEXTANALYSIS_STAT(hintComparisons = 1);
+        if (appended == largest && comparison > 0)
+        {
+            link = &appended->right;
+        }
+        else if (appended == smallest && comparison < 0)
+        {
+            link = &appended->left;
+        }
+        else
+        {
+            appended = nullptr; // Not sorted any more, walk down from the root from now on
+        }
+        currentLevel = appended != nullptr ? appended->level + 1 : 0;
+        TEXTANALYSIS_STAT(startLevel = currentLevel);
     }
-    else if (toLowerCase(word) > toLowerCase(node->word))
+    while (*link != nullptr)
     {
-        // Word should go to the right
-        insertPrivate(node->right, word, currentLevel + 1);
+        int comparison = compareIgnoreCase(word, (*link)->word);
+        if (comparison == 0)
+        {
+            // Word already exists, increase its frequency
+            (*link)->frequency++;
+            TEXTANALYSIS_STAT(
+                recordInsertion(insertStats, currentLevel - startLevel + 1 + hintComparisons, currentLevel));
+            return;
+        }
+        if (mode == BalanceMode::AVL)
+        {
+            path.push_back(link);
+        }
+        // Words that sort earlier go to the left, later ones to the right
+        link = comparison < 0 ? &(*link)->left : &(*link)->right;
+        currentLevel++;
     }
-    else
+
+    // If spot is found, insert new node, copying the word into storage owned by the tree
+    *link = new (nodePool.allocate(sizeof(Node), alignof(Node))) Node(words.intern(word));
+    (*link)->level = currentLevel;
+    TEXTANALYSIS_STAT(recordInsertion(insertStats, currentLevel - startLevel + hintComparisons, currentLevel));
+
+    if (mode == BalanceMode::None)
     {
-        // Word already exists, increase its frequency
-        node->frequency++;
+        // Without rotations, a node attached below an end of a spine becomes that end
+        bool rightEnd = largest == nullptr || link == &largest->right;
+        bool leftEnd = smallest == nullptr || link == &smallest->left;
+        largest = rightEnd ? *link : largest;
+        smallest = leftEnd ? *link : smallest;
+        appended = rightEnd || leftEnd ? *link : nullptr;
+    }
+
+    for (std::size_t i = path.size(); i-- > 0;)
+    {
+        int previousHeight = (*path[i])->height;
+        rebalance(*path[i]);
+        if ((*path[i])->height == previousHeight)
+        {
+            break; // This subtree did not grow, so nothing above it changes either
+        }
     }
 }
 
 // Documented in TextAnalysisBST.h
-void WordBST::insert(const std::string &word)
+void WordBST::resetSpineEnds()
 {
-    insertPrivate(root, word, 0);
+    smallest = largest = root;
+    while (smallest != nullptr && smallest->left != nullptr)
+    {
+        smallest = smallest->left;
+    }
+    while (largest != nullptr && largest->right != nullptr)
+    {
+        largest = largest->right;
+    }
+    appended = nullptr;
 }
 
 // Documented in TextAnalysisBST.h
-void WordBST::writeInOrder(Node *node, std::ofstream &outFile)
+template <typename RootChooser>
+void WordBST::relink(const std::vector<Node *> &nodes, RootChooser chooseRoot)
 {
-    if (node != nullptr)
+    // Pending ranges with the link their subtree root goes into; an explicit stack keeps any shape safe
+    struct Range
+    {
+        std::size_t first, last;
+        Node **link;
+        int level;
+    };
+    std::vector<Range> pending;
+    std::vector<Node *> placed; // Parents are placed before their children
+    placed.reserve(nodes.size());
+    root = nullptr;
+    pending.push_back(Range{0, nodes.size(), &root, 0});
+    while (!pending.empty())
     {
-        writeInOrder(node->left, outFile);
-        // Write the current node's word, frequency, and level
-        outFile << node->word << " " << node->frequency << " (" << node->level << ")\n";
-        writeInOrder(node->right, outFile);
+        Range range = pending.back();
+        pending.pop_back();
+        if (range.first >= range.last)
+        {
+            *range.link = nullptr;
+            continue;
+        }
+        std::size_t middle = chooseRoot(range.first, range.last);
+        Node *node = nodes[middle];
+        node->level = range.level;
+        *range.link = node;
+        placed.push_back(node);
+        pending.push_back(Range{range.first, middle, &node->left, range.level + 1});
+        pending.push_back(Range{middle + 1, range.last, &node->right, range.level + 1});
     }
+    // Heights bottom-up (children were placed after their parents), so AVL insertions can continue afterwards
+    for (std::size_t i = placed.size(); i-- > 0;)
+    {
+        updateHeight(placed[i]);
+    }
+    resetSpineEnds();
 }
 
 // Documented in TextAnalysisBST.h
-void WordBST::computeProbesPrivate(Node *node, int &totalProbes, int &maxProbes, int &wordCount, int currentProbe)
+void WordBST::optimizeForLookups()
 {
-    if (node != nullptr)
+    std::vector<Node *> nodes;
+    visitInOrder([&nodes](Node *node, int) { nodes.push_back(node); });
+    std::size_t n = nodes.size();
+    // weightBefore[i] is the total frequency of the first i words, so a range's weight is a difference
+    std::vector<long long> weightBefore(n + 1, 0);
+    for (std::size_t i = 0; i < n; i++)
+    {
+        weightBefore[i + 1] = weightBefore[i] + nodes[i]->frequency;
+    }
+
+    if (n <= exactOptimalLimit)
     {
-        wordCount++;
-        totalProbes += currentProbe;
-        // Update maxProbes if currentProbe is larger
-        if (currentProbe > maxProbes)
+        // cost[first][last] is the least total weighted depth of a tree over [first, last), bestRoot its root.
+        // Knuth's monotonicity, bestRoot[first][last - 1] <= bestRoot[first][last] <= bestRoot[first + 1][last],
+        // limits the candidate roots and makes the whole table O(n^2).
+        std::size_t width = n + 1;
+        std::vector<long long> cost(width * width, 0);
+        std::vector<std::size_t> bestRoot(width * width, 0);
+        for (std::size_t i = 0; i < n; i++)
+        {
+            cost[i * width + i + 1] = nodes[i]->frequency;
+            bestRoot[i * width + i + 1] = i;
+        }
+        for (std::size_t length = 2; length <= n; length++)
         {
-            maxProbes = currentProbe;
+            for (std::size_t first = 0; first + length <= n; first++)
+            {
+                std::size_t last = first + length;
+                long long best = std::numeric_limits<long long>::max();
+                std::size_t bestIndex = first;
+                for (std::size_t r = bestRoot[first * width + last - 1]; r <= bestRoot[(first + 1) * width + last]; r++)
+                {
+                    long long candidate = cost[first * width + r] + cost[(r + 1) * width + last];
+                    if (candidate < best)
+                    {
+                        best = candidate;
+                        bestIndex = r;
+                    }
+                }
+                // Every word of the range sits one level below the chosen root
+                cost[first * width + last] = best + weightBefore[last] - weightBefore[first];
+                bestRoot[first * width + last] = bestIndex;
+            }
         }
-        // Continue to left and right children
-        computeProbesPrivate(node->left, totalProbes, maxProbes, wordCount, currentProbe + 1);
-        computeProbesPrivate(node->right, totalProbes, maxProbes, wordCount, currentProbe + 1);
+        relink(nodes, [&](std::size_t first, std::size_t last) { return bestRoot[first * width + last]; });
+    }
+    else
+    {
+        // Weight-balanced rule: the root is the word whose frequency contains the range's weighted midpoint
+        relink(nodes, [&](std::size_t first, std::size_t last)
+               {
+                   long long doubledMidpoint = weightBefore[first] + weightBefore[last];
+                   auto split = std::lower_bound(weightBefore.begin() + first + 1, weightBefore.begin() + last,
+                                                 doubledMidpoint,
+                                                 [](long long weight, long long target) { return 2 * weight < target; });
+                   return static_cast<std::size_t>(split - weightBefore.begin()) - 1;
+               });
     }
 }
 
 // Documented in TextAnalysisBST.h
-void WordBST::computeProbes(int &maxProbes, float &averageProbes)
+void WordBST::collectInOrder(std::vector<WordCount> &out) const
 {
-    int totalProbes = 0, wordCount = 0;
-    maxProbes = 0; // Ensure these are reset before computation
-    computeProbesPrivate(root, totalProbes, maxProbes, wordCount, 1);
-    averageProbes = wordCount == 0 ? 0 : static_cast<float>(totalProbes) / wordCount;
+    visitInOrder([&out](const Node *node, int) { out.push_back(WordCount{node->word, node->frequency}); });
 }
 
 // Documented in TextAnalysisBST.h
-void WordBST::writeToFile(const std::string &fileName)
+Node *WordBST::buildBalancedPrivate(const std::vector<WordCount> &sortedWords, std::size_t first, std::size_t last,
+                                    int currentLevel)
 {
-    std::ofstream outFile(fileName, std::ios::app); // Append mode
-    if (!outFile.is_open())
+    if (first >= last)
     {
-        std::cerr << "Failed to open the output file." << std::endl;
-        return;
+        return nullptr;
     }
+    std::size_t middle = first + (last - first) / 2;
+    Node *node = new (nodePool.allocate(sizeof(Node), alignof(Node))) Node(words.intern(sortedWords[middle].word));
+    node->frequency = sortedWords[middle].frequency;
+    node->level = currentLevel;
+    TEXTANALYSIS_STAT(recordInsertion(insertStats, 0, currentLevel));
+    node->left = buildBalancedPrivate(sortedWords, first, middle, currentLevel + 1);
+    node->right = buildBalancedPrivate(sortedWords, middle + 1, last, currentLevel + 1);
+    updateHeight(node); // Keeps the AVL bookkeeping valid should more words be inserted later
+    return node;
+}
 
-    int maxProbes;
-    float averageProbes;
-    // Calculate probe statistics
-    computeProbes(maxProbes, averageProbes);
+// Documented in TextAnalysisBST.h
+void WordBST::buildFromSorted(const std::vector<WordCount> &sortedWords)
+{
+    root = buildBalancedPrivate(sortedWords, 0, sortedWords.size(), 0);
+    resetSpineEnds();
+}
+
+// Documented in TextAnalysisBST.h
+std::size_t WordBST::distinctWords() const
+{
+    return nodePool.getStats().allocations; // Every node is one pool allocation and holds one distinct word
+}
+
+// Documented in TextAnalysisBST.h
+ArenaStats WordBST::getArenaStats() const
+{
+    ArenaStats total = nodePool.getStats();
+    const ArenaStats &wordStats = words.getStats();
+    total.allocations += wordStats.allocations;
+    total.bytesUsed += wordStats.bytesUsed;
+    total.bytesReserved += wordStats.bytesReserved;
+    total.blocks += wordStats.blocks;
+    return total;
+}
 
-    outFile << "Maximum number of probes: " << maxProbes << std::endl;
-    outFile << std::fixed << std::setprecision(1); // Included using <iomanip>
-    outFile << "Average number of probes: " << averageProbes << std::endl;
+// Documented in TextAnalysisBST.h
+bool WordBST::getInsertStats(InsertStats &stats) const
+{
+#if TEXTANALYSIS_STATS
+    stats = insertStats;
+    stats.nodeAllocations = nodePool.getStats().allocations; // Every node comes from the pool
+    return true;
+#else
+    (void)stats; // Nothing is gathered in this build
+    return false;
+#endif
+}
 
-    writeInOrder(root, outFile);
-    outFile << "--------------------\n";
-    outFile.close();
+// Documented in TextAnalysisBST.h
+void WordBST::computeProbes(int &maxProbes, float &averageProbes)
+{
+    long long totalProbes = 0;
+    int wordCount = 0;
+    maxProbes = 0; // Ensure these are reset before computation
+    visitInOrder([&](Node *, int level)
+                 {
+                     int probes = level + 1; // Finding a word takes one probe per node on its path
+                     wordCount++;
+                     totalProbes += probes;
+                     maxProbes = probes > maxProbes ? probes : maxProbes;
+                 });
+    averageProbes = wordCount == 0 ? 0 : static_cast<float>(totalProbes) / wordCount;
+}
+
+// Documented in TextAnalysisBST.h
+float WordBST::computeWeightedProbes()
+{
+    long long weightedTotal = 0, occurrences = 0;
+    visitInOrder([&](Node *node, int level)
+                 {
+                     weightedTotal += static_cast<long long>(node->frequency) * (level + 1);
+                     occurrences += node->frequency;
+                 });
+    return occurrences == 0 ? 0 : static_cast<float>(static_cast<double>(weightedTotal) / occurrences);
+}
+
+// Documented in TextAnalysisBST.h
+void WordBST::collectReport(std::vector<ReportEntry> &entries, ProbeStatistics &statistics)
+{
+    long long totalProbes = 0, weightedTotal = 0, occurrences = 0;
+    int wordCount = 0;
+    statistics.maxProbes = 0;
+    entries.reserve(entries.size() + distinctWords());
+    visitInOrder([&](Node *node, int level)
+                 {
+                     node->level = level;
+                     int probes = level + 1;
+                     wordCount++;
+                     totalProbes += probes;
+                     weightedTotal += static_cast<long long>(node->frequency) * probes;
+                     occurrences += node->frequency;
+                     statistics.maxProbes = probes > statistics.maxProbes ? probes : statistics.maxProbes;
+                     entries.push_back(ReportEntry{node->word, node->frequency, level});
+                 });
+    statistics.averageProbes = wordCount == 0 ? 0 : static_cast<float>(totalProbes) / wordCount;
+    statistics.weightedProbes =
+        occurrences == 0 ? 0 : static_cast<float>(static_cast<double>(weightedTotal) / occurrences);
+}
+
+// Documented in TextAnalysisBST.h
+void WordBST::visitReportLines(const ReportLineVisitor &visit)
+{
+    visitInOrder([&visit](Node *node, int level)
+                 {
+                     node->level = level;
+                     visit(node->word, node->frequency, level);
+                 });
 }
@@ -0,0 +1,330 @@
+// TextAnalysisImplBTree.cpp
+
+#include "TextAnalysisBTree.h"
+
+// Number of word bytes packed into a node's inline prefix
+static const std::size_t prefixBytes = sizeof(std::uint64_t);
+
+// Packs the lowercased first bytes of a word big-endian, so that comparing two packed prefixes as integers
+// orders them like compareIgnoreCase
+static std::uint64_t packPrefix(std::string_view word)
+{
+    std::uint64_t prefix = 0;
+    for (std::size_t i = 0; i < prefixBytes; i++)
+    {
+        prefix <<= 8;
+        if (i < word.size())
+        {
+            prefix |= foldTable.lower[static_cast<unsigned char>(word[i])];
+        }
+    }
+    return prefix;
+}
+
+// Orders a word against a node's word with the same packed prefix. If either word fits in the prefix, the shorter
+// one is a prefix of the other (padding is zero), so the lengths decide; otherwise the rest of the words is compared.
+static int compareBeyondPrefix(const BTreeNode &node, std::size_t slot, std::string_view word)
+{
+    std::size_t length = node.length[slot];
+    if (word.size() <= prefixBytes || length <= prefixBytes)
+    {
+        return word.size() < length ? -1 : (word.size() > length ? 1 : 0);
+    }
+    return compareIgnoreCase(word.substr(prefixBytes),
+                             std::string_view(node.text[slot] + prefixBytes, length - prefixBytes));
+}
+
+// Initialize an empty tree
+BTreeWordCounter::BTreeWordCounter() : root(btreeNoChild), wordCount(0) {}
+
+// The node vector and the word arena release their memory on their own
+BTreeWordCounter::~BTreeWordCounter() {}
+
+// Documented in TextAnalysisBTree.h
+std::uint32_t BTreeWordCounter::newNode()
+{
+    BTreeNode node;
+    node.count = 0;
+    for (std::uint32_t &child : node.child)
+    {
+        child = btreeNoChild;
+    }
+    nodes.push_back(node);
+    return static_cast<std::uint32_t>(nodes.size() - 1);
+}
+
+// Documented in TextAnalysisBTree.h
+void BTreeWordCounter::insert(std::string_view word)
+{
+    add(word, 1);
+}
+
+// Documented in TextAnalysisBTree.h
+void BTreeWordCounter::add(std::string_view word, int frequency)
+{
+    std::uint64_t prefix = packPrefix(word);
+    path.clear();
+    std::uint32_t index = root;
+    while (index != btreeNoChild)
+    {
+        BTreeNode &node = nodes[index];
+        // Skip the words with smaller prefixes, then settle ties on the rest of the words
+        std::uint32_t slot = 0;
+        while (slot < node.count && node.prefix[slot] < prefix)
+        {
+            slot++;
+        }
+        while (slot < node.count && node.prefix[slot] == prefix)
+        {
+            int comparison = compareBeyondPrefix(node, slot, word);
+            if (comparison == 0)
+            {
+                node.frequency[slot] += frequency; // Word already exists, increase its frequency
+                return;
+            }
+            if (comparison < 0)
+            {
+                break;
+            }
+            slot++;
+        }
+        path.push_back(PathStep{index, slot});
+        index = node.child[slot];
+    }
+
+    wordCount++;
+    PendingKey key{prefix, static_cast<std::uint32_t>(word.size()), frequency, words.intern(word).data(),
+                   btreeNoChild};
+    insertAlongPath(key);
+}
+
+// Documented in TextAnalysisBTree.h
+void BTreeWordCounter::insertAlongPath(PendingKey key)
+{
+    for (std::size_t level = path.size(); level-- > 0;)
+    {
+        PathStep step = path[level];
+        if (nodes[step.node].count < btreeNodeKeys)
+        {
+            // Room left: shift the larger words and their right children one slot up
+            BTreeNode &node = nodes[step.node];
+            for (std::uint32_t i = node.count; i > step.slot; i--)
+            {
+                node.prefix[i] = node.prefix[i - 1];
+                node.length[i] = node.length[i - 1];
+                node.frequency[i] = node.frequency[i - 1];
+                node.text[i] = node.text[i - 1];
+                node.child[i + 1] = node.child[i];
+            }
+            node.prefix[step.slot] = key.prefix;
+            node.length[step.slot] = key.length;
+            node.frequency[step.slot] = key.frequency;
+            node.text[step.slot] = key.text;
+            node.child[step.slot + 1] = key.rightChild;
+            node.count++;
+            return;
+        }
+
+        // Full: lay out the node's words plus the new one in order, keep the lower half, move the upper half to a
+        // new sibling and pass the middle word up to the parent
+        std::uint32_t siblingIndex = newNode(); // May move the nodes, so references are taken afterwards
+        BTreeNode &node = nodes[step.node];
+        BTreeNode &sibling = nodes[siblingIndex];
+        PendingKey all[btreeNodeKeys + 1];
+        std::uint32_t children[btreeNodeKeys + 2];
+        for (std::uint32_t i = 0, from = 0; i <= btreeNodeKeys; i++)
+        {
+            if (i == step.slot)
+            {
+                all[i] = key;
+                continue;
+            }
+            all[i] = PendingKey{node.prefix[from], node.length[from], node.frequency[from], node.text[from], 0};
+            from++;
+        }
+        for (std::uint32_t i = 0, from = 0; i <= btreeNodeKeys + 1; i++)
+        {
+            children[i] = i == step.slot + 1 ? key.rightChild : node.child[from++];
+        }
+
+        const std::uint32_t middle = (btreeNodeKeys + 1) / 2;
+        for (std::uint32_t i = 0; i <= btreeNodeKeys; i++)
+        {
+            if (i == middle)
+            {
+                continue;
+            }
+            BTreeNode &target = i < middle ? node : sibling;
+            std::uint32_t slot = i < middle ? i : i - middle - 1;
+            target.prefix[slot] = all[i].prefix;
+            target.length[slot] = all[i].length;
+            target.frequency[slot] = all[i].frequency;
+            target.text[slot] = all[i].text;
+        }
+        for (std::uint32_t i = 0; i <= btreeNodeKeys + 1; i++)
+        {
+            if (i <= middle)
+            {
+                node.child[i] = children[i];
+            }
+            else
+            {
+                sibling.child[i - middle - 1] = children[i];
+            }
+        }
+        for (std::uint32_t i = middle + 1; i <= btreeNodeKeys; i++)
+        {
+            node.child[i] = btreeNoChild;
+        }
+        node.count = middle;
+        sibling.count = btreeNodeKeys - middle;
+
+        key = all[middle];
+        key.rightChild = siblingIndex;
+    }
+
+    // The root was split (or the tree was empty): the pending word becomes a new root one level up
+    std::uint32_t previousRoot = root;
+    root = newNode();
+    BTreeNode &node = nodes[root];
+    node.prefix[0] = key.prefix;
+    node.length[0] = key.length;
+    node.frequency[0] = key.frequency;
+    node.text[0] = key.text;
+    node.child[0] = previousRoot;
+    node.child[1] = key.rightChild;
+    node.count = 1;
+}
+
+// Documented in TextAnalysisBTree.h
+template <typename Visitor>
+void BTreeWordCounter::visitInOrder(Visitor visit) const
+{
+    // Nodes being walked, the next slot to visit in each and their depths; any height is safe on the heap
+    struct Frame
+    {
+        std::uint32_t node;
+        std::uint32_t slot;
+        int depth;
+    };
+    std::vector<Frame> stack;
+    auto descend = [&](std::uint32_t index, int depth)
+    {
+        while (index != btreeNoChild)
+        {
+            stack.push_back(Frame{index, 0, depth});
+            index = nodes[index].child[0];
+            depth++;
+        }
+    };
+
+    descend(root, 0);
+    while (!stack.empty())
+    {
+        Frame &top = stack.back();
+        const BTreeNode &node = nodes[top.node];
+        if (top.slot == node.count)
+        {
+            stack.pop_back();
+            continue;
+        }
+        std::uint32_t slot = top.slot++;
+        int depth = top.depth;
+        visit(node, slot, depth);
+        descend(node.child[slot + 1], depth + 1); // The words between this one and the next
+    }
+}
+
+// Documented in TextAnalysisBTree.h
+void BTreeWordCounter::computeProbes(int &maxProbes, float &averageProbes)
+{
+    long long totalProbes = 0;
+    int wordCount = 0;
+    maxProbes = 0;
+    visitInOrder([&](const BTreeNode &, std::uint32_t, int depth)
+                 {
+                     int probes = depth + 1; // One probe per node visited on the way down
+                     wordCount++;
+                     totalProbes += probes;
+                     maxProbes = probes > maxProbes ? probes : maxProbes;
+                 });
+    averageProbes = wordCount == 0 ? 0 : static_cast<float>(totalProbes) / wordCount;
+}
+
+// Documented in TextAnalysisBTree.h
+float BTreeWordCounter::computeWeightedProbes()
+{
+    long long weightedTotal = 0, occurrences = 0;
+    visitInOrder([&](const BTreeNode &node, std::uint32_t slot, int depth)
+                 {
+                     weightedTotal += static_cast<long long>(node.frequency[slot]) * (depth + 1);
+                     occurrences += node.frequency[slot];
+                 });
+    return occurrences == 0 ? 0 : static_cast<float>(static_cast<double>(weightedTotal) / occurrences);
+}
+
+// Documented in TextAnalysisBTree.h
+void BTreeWordCounter::collectInOrder(std::vector<WordCount> &out) const
+{
+    visitInOrder([&out](const BTreeNode &node, std::uint32_t slot, int)
+                 {
+                     out.push_back(WordCount{std::string_view(node.text[slot], node.length[slot]),
+                                             node.frequency[slot]});
+                 });
+}
+
+// Documented in TextAnalysisBTree.h
+void BTreeWordCounter::collectReport(std::vector<ReportEntry> &entries, ProbeStatistics &statistics)
+{
+    long long totalProbes = 0, weightedTotal = 0, occurrences = 0;
+    int visited = 0;
+    statistics.maxProbes = 0;
+    entries.reserve(entries.size() + wordCount);
+    visitInOrder([&](const BTreeNode &node, std::uint32_t slot, int depth)
+                 {
+                     int probes = depth + 1;
+                     visited++;
+                     totalProbes += probes;
+                     weightedTotal += static_cast<long long>(node.frequency[slot]) * probes;
+                     occurrences += node.frequency[slot];
+                     statistics.maxProbes = probes > statistics.maxProbes ? probes : statistics.maxProbes;
+                     entries.push_back(ReportEntry{std::string_view(node.text[slot], node.length[slot]),
+                                                   node.frequency[slot], depth});
+                 });
+    statistics.averageProbes = visited == 0 ? 0 : static_cast<float>(totalProbes) / visited;
+    statistics.weightedProbes =
+        occurrences == 0 ? 0 : static_cast<float>(static_cast<double>(weightedTotal) / occurrences);
+}
+
+// Documented in TextAnalysisBTree.h
+void BTreeWordCounter::visitReportLines(const ReportLineVisitor &visit)
+{
+    visitInOrder([&visit](const BTreeNode &node, std::uint32_t slot, int depth)
+                 { visit(std::string_view(node.text[slot], node.length[slot]), node.frequency[slot], depth); });
+}
+
+// Documented in TextAnalysisBTree.h
+void BTreeWordCounter::buildFromSorted(const std::vector<WordCount> &sortedWords)
+{
+    for (const WordCount &entry : sortedWords)
+    {
+        add(entry.word, entry.frequency);
+    }
+}
+
+// Documented in TextAnalysisBTree.h
+std::size_t BTreeWordCounter::distinctWords() const
+{
+    return wordCount;
+}
+
+// Documented in TextAnalysisBTree.h
+ArenaStats BTreeWordCounter::getArenaStats() const
+{
+    ArenaStats stats = words.getStats();
+    stats.allocations++; // The node vector
+    stats.blocks++;
+    stats.bytesUsed += nodes.size() * sizeof(BTreeNode);
+    stats.bytesReserved += nodes.capacity() * sizeof(BTreeNode);
+    return stats;
+}
@@ -0,0 +1,150 @@
+// TextAnalysisImplCounter.cpp
+
+#include "TextAnalysisCounter.h"
+#include <iostream>
+#include <queue>
+
+// Documented in TextAnalysisCounter.h
+FoldTable::FoldTable()
+{
+    // ASCII letters only, as std::tolower does in the "C" locale, whatever locale the process is in
+    for (int c = 0; c < 256; c++)
+    {
+        lower[c] = static_cast<unsigned char>(c >= 'A' && c <= 'Z' ? c - 'A' + 'a' : c);
+    }
+}
+
+const FoldTable foldTable;
+
+// Documented in TextAnalysisCounter.h
+int compareIgnoreCase(std::string_view a, std::string_view b)
+{
+    std::size_t length = a.size() < b.size() ? a.size() : b.size();
+    for (std::size_t i = 0; i < length; i++)
+    {
+        int ca = foldTable.lower[static_cast<unsigned char>(a[i])];
+        int cb = foldTable.lower[static_cast<unsigned char>(b[i])];
+        if (ca != cb)
+        {
+            return ca - cb;
+        }
+    }
+    return a.size() < b.size() ? -1 : (a.size() > b.size() ? 1 : 0);
+}
+
+// Documented in TextAnalysisCounter.h
+void WordCounter::writeToFile(const std::string &fileName)
+{
+    ReportWriter outFile;
+    if (!outFile.open(fileName, true)) // Append mode
+    {
+        std::cerr << "Failed to open the output file." << std::endl;
+        return;
+    }
+
+    writeReport(outFile);
+    outFile.close();
+}
+
+// Line closing every report block
+static const char reportSeparator[] = "--------------------\n";
+
+// Documented in TextAnalysisCounter.h
+void appendProbeStatistics(ReportBuffer &out, const ProbeStatistics &statistics, bool weighted)
+{
+    out.append("Maximum number of probes: ");
+    out.appendInteger(statistics.maxProbes);
+    out.append("\nAverage number of probes: ");
+    out.appendFixed1(statistics.averageProbes); // Same digits as std::fixed with std::setprecision(1)
+    out.append('\n');
+    if (weighted)
+    {
+        out.append("Weighted average number of probes: ");
+        out.appendFixed1(statistics.weightedProbes);
+        out.append('\n');
+    }
+}
+
+// Documented in TextAnalysisCounter.h
+void appendReportLine(ReportBuffer &out, std::string_view word, int frequency, int position)
+{
+    out.append(word);
+    out.append(' ');
+    out.appendInteger(frequency);
+    out.append(" (");
+    out.appendInteger(position);
+    out.append(")\n");
+}
+
+// Documented in TextAnalysisCounter.h
+void appendReport(ReportBuffer &out, const std::vector<ReportEntry> &entries, const ProbeStatistics &statistics,
+                  bool weighted)
+{
+    appendProbeStatistics(out, statistics, weighted);
+    for (const ReportEntry &entry : entries)
+    {
+        appendReportLine(out, entry.word, entry.frequency, entry.position);
+    }
+    out.append(reportSeparator);
+}
+
+// Documented in TextAnalysisCounter.h
+void WordCounter::writeReport(ReportBuffer &out)
+{
+    // The statistics open the report, so they take their own traversals before the lines are streamed
+    ProbeStatistics statistics;
+    computeProbes(statistics.maxProbes, statistics.averageProbes);
+    statistics.weightedProbes = reportWeighted ? computeWeightedProbes() : 0;
+    appendProbeStatistics(out, statistics, reportWeighted);
+    visitReportLines([&out](std::string_view word, int frequency, int position)
+                     { appendReportLine(out, word, frequency, position); });
+    out.append(reportSeparator);
+}
+
+// Documented in TextAnalysisCounter.h
+void mergeSortedRuns(const std::vector<std::vector<WordCount>> &runs, std::vector<WordCount> &merged)
+{
+    // Cursor into one run; the heap orders cursors by their current word, then by run so earlier runs win ties
+    struct Cursor
+    {
+        std::size_t run;
+        std::size_t position;
+    };
+    auto later = [&runs](const Cursor &a, const Cursor &b)
+    {
+        int comparison = compareIgnoreCase(runs[a.run][a.position].word, runs[b.run][b.position].word);
+        return comparison != 0 ? comparison > 0 : a.run > b.run;
+    };
+    std::priority_queue<Cursor, std::vector<Cursor>, decltype(later)> heap(later);
+
+    std::size_t total = 0;
+    for (std::size_t run = 0; run < runs.size(); run++)
+    {
+        total += runs[run].size();
+        if (!runs[run].empty())
+        {
+            heap.push(Cursor{run, 0});
+        }
+    }
+    merged.reserve(merged.size() + total);
+
+    std::size_t mergedStart = merged.size();
+    while (!heap.empty())
+    {
+        Cursor cursor = heap.top();
+        heap.pop();
+        const WordCount &entry = runs[cursor.run][cursor.position];
+        if (merged.size() > mergedStart && compareIgnoreCase(merged.back().word, entry.word) == 0)
+        {
+            merged.back().frequency += entry.frequency; // Same word seen in another part
+        }
+        else
+        {
+            merged.push_back(entry);
+        }
+        if (++cursor.position < runs[cursor.run].size())
+        {
+            heap.push(cursor);
+        }
+    }
+}
@@ -0,0 +1,254 @@
+// TextAnalysisImplHash.cpp
+
+#include "TextAnalysisHash.h"
+#include <algorithm>
+#include <cstring>
+
+// Number of slots of a new table
+static const std::size_t initialCapacity = 64;
+
+// Bytes of a long word kept inline in its slot, in front of the pointer to the full copy
+static const std::size_t inlinePrefixLength = inlineKeyLength - sizeof(const char *);
+
+// FNV-1a hash of the lowercased word, so that words differing only by case share a slot
+static std::uint64_t hashIgnoreCase(std::string_view word)
+{
+    std::uint64_t hash = 14695981039346656037ULL;
+    for (char c : word)
+    {
+        hash ^= foldTable.lower[static_cast<unsigned char>(c)];
+        hash *= 1099511628211ULL;
+    }
+    return hash;
+}
+
+// Case-insensitive equality of two byte ranges of the same length
+static bool equalIgnoreCase(const char *a, const char *b, std::size_t length)
+{
+    for (std::size_t i = 0; i < length; i++)
+    {
+        if (foldTable.lower[static_cast<unsigned char>(a[i])] != foldTable.lower[static_cast<unsigned char>(b[i])])
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Initialize an empty table
+HashWordCounter::HashWordCounter() : slots(initialCapacity, HashSlot()), count(0) {}
+
+// The slot array and the word arena release their memory on their own
+HashWordCounter::~HashWordCounter() {}
+
+// Documented in TextAnalysisHash.h
+std::string_view HashWordCounter::wordOf(const HashSlot &slot)
+{
+    if (slot.length <= inlineKeyLength)
+    {
+        return std::string_view(slot.key, slot.length);
+    }
+    const char *pointer;
+    std::memcpy(&pointer, slot.key + inlinePrefixLength, sizeof(pointer));
+    return std::string_view(pointer, slot.length);
+}
+
+// Documented in TextAnalysisHash.h
+int HashWordCounter::probesAt(std::size_t index) const
+{
+    std::size_t mask = slots.size() - 1;
+    std::size_t home = static_cast<std::size_t>(slots[index].hash) & mask;
+    return static_cast<int>(((index - home) & mask) + 1);
+}
+
+// Documented in TextAnalysisHash.h
+void HashWordCounter::grow()
+{
+    std::vector<HashSlot> previous(slots.size() * 2, HashSlot());
+    previous.swap(slots);
+    std::size_t mask = slots.size() - 1;
+    for (const HashSlot &slot : previous)
+    {
+        if (slot.frequency != 0)
+        {
+            // Words are distinct, so each one simply takes the first free slot from its home
+            std::size_t index = static_cast<std::size_t>(slot.hash) & mask;
+            while (slots[index].frequency != 0)
+            {
+                index = (index + 1) & mask;
+            }
+            slots[index] = slot;
+        }
+    }
+}
+
+// Documented in TextAnalysisHash.h
+void HashWordCounter::add(std::string_view word, int frequency)
+{
+    std::uint64_t hash = hashIgnoreCase(word);
+    std::size_t mask = slots.size() - 1;
+    std::size_t index = static_cast<std::size_t>(hash) & mask;
+
+    while (slots[index].frequency != 0)
+    {
+        HashSlot &slot = slots[index];
+        if (slot.hash == hash && slot.length == word.size())
+        {
+            // Check the inline bytes first, they reject nearly every remaining mismatch
+            std::size_t inlineBytes = word.size() <= inlineKeyLength ? word.size() : inlinePrefixLength;
+            if (equalIgnoreCase(slot.key, word.data(), inlineBytes) &&
+                (word.size() <= inlineKeyLength ||
+                 equalIgnoreCase(wordOf(slot).data() + inlineBytes, word.data() + inlineBytes,
+                                 word.size() - inlineBytes)))
+            {
+                slot.frequency += frequency; // Word already exists, increase its frequency
+                return;
+            }
+        }
+        index = (index + 1) & mask;
+    }
+
+    // Keep the load factor at or below 70% so that probe sequences stay short
+    if ((count + 1) * 10 > slots.size() * 7)
+    {
+        grow();
+        add(word, frequency);
+        return;
+    }
+
+    HashSlot &slot = slots[index];
+    slot.hash = hash;
+    slot.length = static_cast<std::uint32_t>(word.size());
+    slot.frequency = frequency;
+    if (word.size() <= inlineKeyLength)
+    {
+        std::memcpy(slot.key, word.data(), word.size());
+    }
+    else
+    {
+        const char *copy = words.intern(word).data();
+        std::memcpy(slot.key, word.data(), inlinePrefixLength);
+        std::memcpy(slot.key + inlinePrefixLength, &copy, sizeof(copy));
+    }
+    count++;
+}
+
+// Documented in TextAnalysisHash.h
+void HashWordCounter::insert(std::string_view word)
+{
+    add(word, 1);
+}
+
+// Documented in TextAnalysisHash.h
+void HashWordCounter::buildFromSorted(const std::vector<WordCount> &sortedWords)
+{
+    for (const WordCount &entry : sortedWords)
+    {
+        add(entry.word, entry.frequency);
+    }
+}
+
+// Documented in TextAnalysisHash.h
+void HashWordCounter::computeProbes(int &maxProbes, float &averageProbes)
+{
+    long long totalProbes = 0;
+    maxProbes = 0;
+    for (std::size_t index = 0; index < slots.size(); index++)
+    {
+        if (slots[index].frequency != 0)
+        {
+            int probes = probesAt(index);
+            totalProbes += probes;
+            maxProbes = probes > maxProbes ? probes : maxProbes;
+        }
+    }
+    averageProbes = count == 0 ? 0 : static_cast<float>(totalProbes) / count;
+}
+
+// Documented in TextAnalysisHash.h
+float HashWordCounter::computeWeightedProbes()
+{
+    long long weightedTotal = 0, occurrences = 0;
+    for (std::size_t index = 0; index < slots.size(); index++)
+    {
+        if (slots[index].frequency != 0)
+        {
+            weightedTotal += static_cast<long long>(slots[index].frequency) * probesAt(index);
+            occurrences += slots[index].frequency;
+        }
+    }
+    return occurrences == 0 ? 0 : static_cast<float>(static_cast<double>(weightedTotal) / occurrences);
+}
+
+// Documented in TextAnalysisHash.h
+void HashWordCounter::collectInOrder(std::vector<WordCount> &out) const
+{
+    std::size_t first = out.size();
+    for (const HashSlot &slot : slots)
+    {
+        if (slot.frequency != 0)
+        {
+            out.push_back(WordCount{wordOf(slot), slot.frequency});
+        }
+    }
+    std::sort(out.begin() + first, out.end(), [](const WordCount &a, const WordCount &b)
+              { return compareIgnoreCase(a.word, b.word) < 0; });
+}
+
+// Documented in TextAnalysisHash.h
+void HashWordCounter::sortOccupied(std::vector<std::size_t> &order) const
+{
+    order.reserve(order.size() + count);
+    std::size_t first = order.size();
+    for (std::size_t index = 0; index < slots.size(); index++)
+    {
+        if (slots[index].frequency != 0)
+        {
+            order.push_back(index);
+        }
+    }
+    std::sort(order.begin() + first, order.end(), [this](std::size_t a, std::size_t b)
+              { return compareIgnoreCase(wordOf(slots[a]), wordOf(slots[b])) < 0; });
+}
+
+// Documented in TextAnalysisHash.h
+void HashWordCounter::collectReport(std::vector<ReportEntry> &entries, ProbeStatistics &statistics)
+{
+    computeProbes(statistics.maxProbes, statistics.averageProbes);
+    statistics.weightedProbes = computeWeightedProbes();
+    std::vector<std::size_t> order;
+    sortOccupied(order);
+    entries.reserve(entries.size() + order.size());
+    for (std::size_t index : order)
+    {
+        entries.push_back(ReportEntry{wordOf(slots[index]), slots[index].frequency, probesAt(index) - 1});
+    }
+}
+
+// Documented in TextAnalysisHash.h
+void HashWordCounter::visitReportLines(const ReportLineVisitor &visit)
+{
+    std::vector<std::size_t> order;
+    sortOccupied(order);
+    for (std::size_t index : order)
+    {
+        visit(wordOf(slots[index]), slots[index].frequency, probesAt(index) - 1);
+    }
+}
+
+// Documented in TextAnalysisHash.h
+std::size_t HashWordCounter::distinctWords() const
+{
+    return count;
+}
+
+// Documented in TextAnalysisHash.h
+ArenaStats HashWordCounter::getArenaStats() const
+{
+    ArenaStats stats = words.getStats();
+    stats.allocations++; // The slot array
+    stats.blocks++;
+    stats.bytesUsed += count * sizeof(HashSlot);
+    stats.bytesReserved += slots.size() * sizeof(HashSlot);
+    return stats;
+}
@@ -0,0 +1,252 @@
+// TextAnalysisImplIndex.cpp
+
+#include "TextAnalysisIndex.h"
+#include "TextAnalysisTokenizer.h"
+#include <atomic>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// Identifies index files; the trailing bytes keep the header 8-byte aligned
+static const char indexMagic[8] = {'W', 'J', 'I', 'N', 'D', 'E', 'X', '\0'};
+
+// Layout of the start of an index file
+struct IndexHeader
+{
+    char magic[8];               // indexMagic
+    std::uint32_t formatVersion; // indexFormatVersion at the time of writing
+    std::uint32_t rulesVersion;  // tokenizerRulesVersion at the time of writing
+    std::uint32_t configuration; // IndexKey::configuration
+    std::uint32_t wordCount;     // Number of IndexEntry records after the header
+    std::uint64_t sourceSize;    // IndexKey::sourceSize
+    std::int64_t sourceModified; // IndexKey::sourceModified
+    std::int32_t maxProbes;      // Probe statistics of the report
+    float averageProbes;         // Probe statistics of the report
+    float weightedProbes;        // Probe statistics of the report
+    std::uint32_t pathLength;    // Length of the source path, stored at the start of the blob
+    std::uint64_t blobSize;      // Number of bytes in the blob after the entries
+};
+
+// One report line; the word is blob[offset, offset + length)
+struct IndexEntry
+{
+    std::uint32_t offset;
+    std::uint32_t length;
+    std::int32_t frequency;
+    std::int32_t position;
+};
+
+static_assert(sizeof(IndexHeader) == 64, "IndexHeader must not contain padding");
+static_assert(sizeof(IndexEntry) == 16, "IndexEntry must not contain padding");
+
+// Documented in TextAnalysisIndex.h
+bool describeIndexSource(const std::string &fileName, IndexKey &key)
+{
+    struct stat info;
+    if (stat(fileName.c_str(), &info) != 0 || !S_ISREG(info.st_mode))
+    {
+        return false;
+    }
+    key.sourcePath = fileName;
+    key.sourceSize = static_cast<std::uint64_t>(info.st_size);
+    key.sourceModified = static_cast<std::int64_t>(info.st_mtim.tv_sec) * 1000000000 + info.st_mtim.tv_nsec;
+    return true;
+}
+
+// Documented in TextAnalysisIndex.h
+std::string indexPathFor(const std::string &cacheDirectory, const IndexKey &key)
+{
+    // FNV-1a over the path
+    std::uint64_t hash = 14695981039346656037ULL;
+    for (unsigned char c : key.sourcePath)
+    {
+        hash = (hash ^ c) * 1099511628211ULL;
+    }
+    char name[40];
+    std::snprintf(name, sizeof(name), "%016llx-%x.idx", static_cast<unsigned long long>(hash), key.configuration);
+    return cacheDirectory + "/" + name;
+}
+
+// Initialize an index with nothing mapped
+WordIndex::WordIndex() : mapping(nullptr), mappingSize(0), header(nullptr), entries(nullptr), blob(nullptr) {}
+
+// Release the mapping when the index goes away
+WordIndex::~WordIndex()
+{
+    close();
+}
+
+// Documented in TextAnalysisIndex.h
+void WordIndex::close()
+{
+    if (mapping != nullptr)
+    {
+        munmap(mapping, mappingSize);
+    }
+    mapping = nullptr;
+    mappingSize = 0;
+    header = nullptr;
+    entries = nullptr;
+    blob = nullptr;
+}
+
+// Documented in TextAnalysisIndex.h
+bool WordIndex::open(const std::string &indexPath, const IndexKey &key)
+{
+    close();
+    int fd = ::open(indexPath.c_str(), O_RDONLY);
+    if (fd < 0)
+    {
+        return false;
+    }
+    struct stat info;
+    if (fstat(fd, &info) != 0 || !S_ISREG(info.st_mode) || info.st_size < static_cast<off_t>(sizeof(IndexHeader)))
+    {
+        ::close(fd);
+        return false;
+    }
+    std::size_t length = static_cast<std::size_t>(info.st_size);
+    void *mapped = mmap(nullptr, length, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd); // The mapping stays valid on its own
+    if (mapped == MAP_FAILED)
+    {
+        return false;
+    }
+    mapping = mapped;
+    mappingSize = length;
+    header = static_cast<const IndexHeader *>(mapping);
+
+    // The sizes must add up exactly, which also rejects files cut short by a crash
+    std::uint64_t entryBytes = static_cast<std::uint64_t>(header->wordCount) * sizeof(IndexEntry);
+    if (std::memcmp(header->magic, indexMagic, sizeof(indexMagic)) != 0 ||
+        header->formatVersion != indexFormatVersion || header->rulesVersion != tokenizerRulesVersion ||
+        header->blobSize > length || sizeof(IndexHeader) + entryBytes + header->blobSize != length ||
+        header->pathLength > header->blobSize)
+    {
+        close();
+        return false;
+    }
+    entries = reinterpret_cast<const IndexEntry *>(static_cast<const char *>(mapping) + sizeof(IndexHeader));
+    blob = reinterpret_cast<const char *>(entries + header->wordCount);
+
+    if (header->configuration != key.configuration || header->sourceSize != key.sourceSize ||
+        header->sourceModified != key.sourceModified ||
+        std::string_view(blob, header->pathLength) != std::string_view(key.sourcePath))
+    {
+        close();
+        return false;
+    }
+    for (std::uint32_t i = 0; i < header->wordCount; i++)
+    {
+        if (entries[i].offset > header->blobSize || entries[i].length > header->blobSize - entries[i].offset)
+        {
+            close();
+            return false;
+        }
+    }
+    return true;
+}
+
+// Documented in TextAnalysisIndex.h
+std::size_t WordIndex::size() const
+{
+    return header == nullptr ? 0 : header->wordCount;
+}
+
+// Documented in TextAnalysisIndex.h
+void WordIndex::writeReport(ReportBuffer &out, bool weighted) const
+{
+    if (header == nullptr)
+    {
+        return;
+    }
+    ProbeStatistics statistics;
+    statistics.maxProbes = header->maxProbes;
+    statistics.averageProbes = header->averageProbes;
+    statistics.weightedProbes = header->weightedProbes;
+    appendProbeStatistics(out, statistics, weighted);
+    for (std::uint32_t i = 0; i < header->wordCount; i++)
+    {
+        const IndexEntry &entry = entries[i];
+        appendReportLine(out, std::string_view(blob + entry.offset, entry.length), entry.frequency, entry.position);
+    }
+    out.append("--------------------\n");
+}
+
+// Documented in TextAnalysisIndex.h
+bool WordIndex::save(const std::string &indexPath, const IndexKey &key, const std::vector<ReportEntry> &entries,
+                     const ProbeStatistics &statistics)
+{
+    IndexHeader header;
+    std::memset(&header, 0, sizeof(header));
+    std::memcpy(header.magic, indexMagic, sizeof(indexMagic));
+    header.formatVersion = indexFormatVersion;
+    header.rulesVersion = tokenizerRulesVersion;
+    header.configuration = key.configuration;
+    header.wordCount = static_cast<std::uint32_t>(entries.size());
+    header.sourceSize = key.sourceSize;
+    header.sourceModified = key.sourceModified;
+    header.maxProbes = statistics.maxProbes;
+    header.averageProbes = statistics.averageProbes;
+    header.weightedProbes = statistics.weightedProbes;
+    header.pathLength = static_cast<std::uint32_t>(key.sourcePath.size());
+
+    // Lay out the records and the blob in one buffer, the blob starting with the source path
+    std::string blob = key.sourcePath;
+    std::vector<IndexEntry> records(entries.size());
+    for (std::size_t i = 0; i < entries.size(); i++)
+    {
+        records[i].offset = static_cast<std::uint32_t>(blob.size());
+        records[i].length = static_cast<std::uint32_t>(entries[i].word.size());
+        records[i].frequency = entries[i].frequency;
+        records[i].position = entries[i].position;
+        blob.append(entries[i].word);
+    }
+    if (entries.size() > UINT32_MAX || blob.size() > UINT32_MAX)
+    {
+        return false; // Offsets would not fit in the record layout
+    }
+    header.blobSize = blob.size();
+
+    std::string contents;
+    contents.reserve(sizeof(header) + records.size() * sizeof(IndexEntry) + blob.size());
+    contents.append(reinterpret_cast<const char *>(&header), sizeof(header));
+    contents.append(reinterpret_cast<const char *>(records.data()), records.size() * sizeof(IndexEntry));
+    contents.append(blob);
+
+    // Several threads (or processes) may save the same index, so every writer gets its own temporary file
+    static std::atomic<unsigned> saves(0);
+    std::string temporaryPath = indexPath + ".tmp" + std::to_string(getpid()) + "-" + std::to_string(saves++);
+    int fd = ::open(temporaryPath.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0)
+    {
+        return false;
+    }
+    const char *cursor = contents.data();
+    std::size_t remaining = contents.size();
+    while (remaining > 0)
+    {
+        ssize_t written = write(fd, cursor, remaining);
+        if (written < 0)
+        {
+            if (errno == EINTR)
+            {
+                continue;
+            }
+            break;
+        }
+        cursor += written;
+        remaining -= static_cast<std::size_t>(written);
+    }
+    bool success = ::close(fd) == 0 && remaining == 0;
+    if (!success || rename(temporaryPath.c_str(), indexPath.c_str()) != 0)
+    {
+        unlink(temporaryPath.c_str());
+        return false;
+    }
+    return true;
+}
@@ -0,0 +1,460 @@
+// TextAnalysisImplRadix.cpp
+
+#include "TextAnalysisRadix.h"
+#include <cstring>
+#include <stdexcept>
+
+/*
+ * Layout of a node record, in 32-bit words:
+ *   [0]  frequency of the word ending at the node (0 if none)
+ *   [1]  label length (bits 0-15), number of children (bits 16-24), capacity class (bits 25-28)
+ *   then the label bytes, the child keys (one byte each) and the child references, each padded to whole words.
+ * The child keys are sorted, and a child's label continues the word after its key byte.
+ */
+
+// Bits of a reference selecting the word within a chunk; the rest select the chunk
+static const unsigned offsetBits = 20;
+
+// Largest chunk, in words; chunks start small so that tiny files stay cheap
+static const std::uint32_t maxChunkWords = 1u << offsetBits;
+
+// Most chunks a reference can select. A record takes at least two words, so no record starts on the last word of
+// the last chunk and no reference equals noNode
+static const std::size_t maxChunks = std::size_t(1) << (32 - offsetBits);
+
+// Size of the first chunk, in words
+static const std::uint32_t firstChunkWords = 1024;
+
+// Longest label a node can hold; longer word endings are spread over a chain of nodes
+static const std::size_t maxLabelLength = 0xFFFF;
+
+// Largest record recycled through the free lists, in words
+static const std::size_t maxRecycledWords = 256;
+
+// Reference value meaning no node
+static const std::uint32_t noNode = 0xFFFFFFFFu;
+
+// Number of children a capacity class can hold
+static std::size_t capacityOf(unsigned sizeClass)
+{
+    return sizeClass == 0 ? 0 : std::size_t(1) << (sizeClass - 1);
+}
+
+// Number of words a record with the given label length and capacity class takes
+static std::size_t recordWords(std::size_t labelLength, unsigned sizeClass)
+{
+    std::size_t capacity = capacityOf(sizeClass);
+    return 2 + (labelLength + 3) / 4 + (capacity + 3) / 4 + capacity;
+}
+
+// Field accessors of a record
+static std::size_t labelLengthOf(const std::uint32_t *node)
+{
+    return node[1] & 0xFFFF;
+}
+
+static std::size_t childCountOf(const std::uint32_t *node)
+{
+    return (node[1] >> 16) & 0x1FF;
+}
+
+static unsigned sizeClassOf(const std::uint32_t *node)
+{
+    return (node[1] >> 25) & 0xF;
+}
+
+static void setChildCount(std::uint32_t *node, std::size_t count)
+{
+    node[1] = (node[1] & ~(0x1FFu << 16)) | static_cast<std::uint32_t>(count) << 16;
+}
+
+static unsigned char *labelOf(std::uint32_t *node)
+{
+    return reinterpret_cast<unsigned char *>(node + 2);
+}
+
+static const unsigned char *labelOf(const std::uint32_t *node)
+{
+    return reinterpret_cast<const unsigned char *>(node + 2);
+}
+
+static unsigned char *keysOf(std::uint32_t *node)
+{
+    return reinterpret_cast<unsigned char *>(node + 2 + (labelLengthOf(node) + 3) / 4);
+}
+
+static const unsigned char *keysOf(const std::uint32_t *node)
+{
+    return reinterpret_cast<const unsigned char *>(node + 2 + (labelLengthOf(node) + 3) / 4);
+}
+
+static std::uint32_t *childrenOf(std::uint32_t *node)
+{
+    return node + 2 + (labelLengthOf(node) + 3) / 4 + (capacityOf(sizeClassOf(node)) + 3) / 4;
+}
+
+static const std::uint32_t *childrenOf(const std::uint32_t *node)
+{
+    return node + 2 + (labelLengthOf(node) + 3) / 4 + (capacityOf(sizeClassOf(node)) + 3) / 4;
+}
+
+// Initialize an empty trie; the root is created with the first word
+RadixWordCounter::RadixWordCounter()
+    : chunkUsed(0), chunkSize(0), freeRecords(maxRecycledWords + 1), root(noNode), wordCount(0)
+{
+}
+
+// The chunks release their memory on their own
+RadixWordCounter::~RadixWordCounter() {}
+
+// Documented in TextAnalysisRadix.h
+std::uint32_t *RadixWordCounter::record(std::uint32_t reference) const
+{
+    return chunks[reference >> offsetBits].get() + (reference & (maxChunkWords - 1));
+}
+
+// Documented in TextAnalysisRadix.h
+std::uint32_t RadixWordCounter::allocateNode(std::size_t labelLength, unsigned sizeClass)
+{
+    std::size_t words = recordWords(labelLength, sizeClass);
+    std::uint32_t reference;
+    if (words <= maxRecycledWords && !freeRecords[words].empty())
+    {
+        reference = freeRecords[words].back();
+        freeRecords[words].pop_back();
+    }
+    else
+    {
+        if (chunks.empty() || chunkSize - chunkUsed < words)
+        {
+            // Start a new chunk, twice as large as the last one up to the reference limit (and always large
+            // enough for the record); the tail of the previous chunk is left unused
+            std::uint32_t size = chunks.empty() ? firstChunkWords : chunkSize * 2;
+            size = size > maxChunkWords ? maxChunkWords : size;
+            size = size < words ? static_cast<std::uint32_t>(words) : size;
+            if (chunks.size() == maxChunks)
+            {
+                throw std::length_error("RadixWordCounter: node pool exceeds the 32-bit reference limit");
+            }
+            chunks.emplace_back(new std::uint32_t[size]); // Left uninitialized, untouched pages cost no memory
+            chunkSize = size;
+            chunkUsed = 0;
+            poolStats.blocks++;
+            poolStats.bytesReserved += size * sizeof(std::uint32_t);
+        }
+        reference = static_cast<std::uint32_t>(chunks.size() - 1) << offsetBits | chunkUsed;
+        chunkUsed += static_cast<std::uint32_t>(words);
+    }
+    poolStats.allocations++;
+    poolStats.bytesUsed += words * sizeof(std::uint32_t);
+
+    std::uint32_t *node = record(reference);
+    node[0] = 0;
+    node[1] = static_cast<std::uint32_t>(labelLength) | static_cast<std::uint32_t>(sizeClass) << 25;
+    return reference;
+}
+
+// Documented in TextAnalysisRadix.h
+void RadixWordCounter::releaseNode(std::uint32_t reference)
+{
+    const std::uint32_t *node = record(reference);
+    std::size_t words = recordWords(labelLengthOf(node), sizeClassOf(node));
+    poolStats.bytesUsed -= words * sizeof(std::uint32_t);
+    if (words <= maxRecycledWords)
+    {
+        freeRecords[words].push_back(reference);
+    }
+}
+
+// Documented in TextAnalysisRadix.h
+std::uint32_t RadixWordCounter::rebuildNode(std::uint32_t reference, std::size_t labelStart, unsigned sizeClass)
+{
+    const std::uint32_t *from = record(reference);
+    std::size_t labelLength = labelLengthOf(from) - labelStart;
+    std::uint32_t copyReference = allocateNode(labelLength, sizeClass); // Never reuses the record being copied
+    std::uint32_t *copy = record(copyReference);
+    std::size_t count = childCountOf(from);
+    copy[0] = from[0];
+    setChildCount(copy, count);
+    std::memcpy(labelOf(copy), labelOf(from) + labelStart, labelLength);
+    std::memcpy(keysOf(copy), keysOf(from), count);
+    std::memcpy(childrenOf(copy), childrenOf(from), count * sizeof(std::uint32_t));
+    releaseNode(reference);
+    return copyReference;
+}
+
+// Documented in TextAnalysisRadix.h
+std::uint32_t RadixWordCounter::createLeaf(std::string_view word, std::size_t start, int frequency)
+{
+    std::uint32_t first = noNode;
+    std::uint32_t *link = &first;
+    while (true)
+    {
+        std::size_t remaining = word.size() - start;
+        std::size_t length = remaining > maxLabelLength ? maxLabelLength : remaining;
+        bool more = length < remaining; // The rest continues in a child keyed by the next byte
+        std::uint32_t reference = allocateNode(length, more ? 1 : 0);
+        std::uint32_t *node = record(reference);
+        unsigned char *label = labelOf(node);
+        for (std::size_t i = 0; i < length; i++)
+        {
+            label[i] = foldTable.lower[static_cast<unsigned char>(word[start + i])];
+        }
+        *link = reference;
+        if (!more)
+        {
+            node[0] = static_cast<std::uint32_t>(frequency);
+            return first;
+        }
+        keysOf(node)[0] = foldTable.lower[static_cast<unsigned char>(word[start + length])];
+        setChildCount(node, 1);
+        link = childrenOf(node);
+        start += length + 1;
+    }
+}
+
+// Documented in TextAnalysisRadix.h
+void RadixWordCounter::addChild(std::uint32_t *link, unsigned char key, std::uint32_t child)
+{
+    std::uint32_t *node = record(*link);
+    std::size_t count = childCountOf(node);
+    if (count == capacityOf(sizeClassOf(node)))
+    {
+        // Full: move into a record with twice the room (the parent's link follows it)
+        *link = rebuildNode(*link, 0, sizeClassOf(node) + 1);
+        node = record(*link);
+    }
+    unsigned char *keys = keysOf(node);
+    std::uint32_t *children = childrenOf(node);
+    std::size_t slot = count;
+    while (slot > 0 && keys[slot - 1] > key)
+    {
+        keys[slot] = keys[slot - 1];
+        children[slot] = children[slot - 1];
+        slot--;
+    }
+    keys[slot] = key;
+    children[slot] = child;
+    setChildCount(node, count + 1);
+}
+
+// Documented in TextAnalysisRadix.h
+void RadixWordCounter::insert(std::string_view word)
+{
+    add(word, 1);
+}
+
+// Documented in TextAnalysisRadix.h
+void RadixWordCounter::add(std::string_view word, int frequency)
+{
+    if (root == noNode)
+    {
+        root = allocateNode(0, 0);
+    }
+
+    std::uint32_t *link = &root; // The location holding the current node's reference
+    std::size_t position = 0;    // Bytes of the word spelled by the nodes above the current one
+    while (true)
+    {
+        std::uint32_t *node = record(*link);
+        const unsigned char *label = labelOf(node);
+        std::size_t labelLength = labelLengthOf(node);
+        std::size_t common = 0;
+        while (common < labelLength && position + common < word.size() &&
+               label[common] == foldTable.lower[static_cast<unsigned char>(word[position + common])])
+        {
+            common++;
+        }
+
+        if (common < labelLength)
+        {
+            // The word leaves (or ends inside) the label: split the node into a branch holding the shared bytes,
+            // followed by the rest of the old node and, unless the word ends at the branch, a leaf for the word
+            bool endsHere = position + common == word.size();
+            unsigned char oldKey = label[common];
+            std::uint32_t branch = allocateNode(common, endsHere ? 1 : 2);
+            std::uint32_t *branchNode = record(branch);
+            std::memcpy(labelOf(branchNode), label, common);
+            std::uint32_t rest = rebuildNode(*link, common + 1, sizeClassOf(node));
+            *link = branch;
+            addChild(link, oldKey, rest);
+            if (endsHere)
+            {
+                branchNode[0] = static_cast<std::uint32_t>(frequency);
+            }
+            else
+            {
+                addChild(link, foldTable.lower[static_cast<unsigned char>(word[position + common])],
+                         createLeaf(word, position + common + 1, frequency));
+            }
+            wordCount++;
+            return;
+        }
+
+        position += labelLength;
+        if (position == word.size())
+        {
+            if (node[0] == 0)
+            {
+                wordCount++; // A branch node that did not end a word so far
+            }
+            node[0] += static_cast<std::uint32_t>(frequency);
+            return;
+        }
+
+        // Follow the child keyed by the next byte, or hang a new leaf there
+        unsigned char key = foldTable.lower[static_cast<unsigned char>(word[position])];
+        const unsigned char *keys = keysOf(node);
+        std::size_t count = childCountOf(node);
+        std::size_t slot = 0;
+        while (slot < count && keys[slot] < key)
+        {
+            slot++;
+        }
+        if (slot == count || keys[slot] != key)
+        {
+            addChild(link, key, createLeaf(word, position + 1, frequency));
+            wordCount++;
+            return;
+        }
+        link = childrenOf(node) + slot;
+        position++;
+    }
+}
+
+// Documented in TextAnalysisRadix.h
+template <typename Visitor>
+void RadixWordCounter::visitInOrder(Visitor visit) const
+{
+    if (root == noNode)
+    {
+        return;
+    }
+    // Nodes being walked, the next child to visit in each and the length of the word before the node's bytes
+    struct Frame
+    {
+        const std::uint32_t *node;
+        std::size_t nextChild;
+        std::size_t wordLength;
+        int depth;
+    };
+    std::vector<Frame> stack;
+    std::string word; // The bytes spelled from the root down to the current node
+    auto enter = [&](const std::uint32_t *node, int depth)
+    {
+        stack.push_back(Frame{node, 0, word.size(), depth});
+        word.append(reinterpret_cast<const char *>(labelOf(node)), labelLengthOf(node));
+        if (node[0] != 0)
+        {
+            visit(std::string_view(word), static_cast<int>(node[0]), depth); // A word sorts before its extensions
+        }
+    };
+
+    enter(record(root), 0);
+    while (!stack.empty())
+    {
+        Frame &top = stack.back();
+        if (top.nextChild == childCountOf(top.node))
+        {
+            word.resize(top.wordLength);
+            stack.pop_back();
+            if (!stack.empty())
+            {
+                word.resize(word.size() - 1); // The key byte leading to the finished child
+            }
+            continue;
+        }
+        std::size_t slot = top.nextChild++;
+        const std::uint32_t *child = record(childrenOf(top.node)[slot]);
+        int depth = top.depth + 1;
+        word.push_back(static_cast<char>(keysOf(top.node)[slot]));
+        enter(child, depth);
+    }
+}
+
+// Documented in TextAnalysisRadix.h
+void RadixWordCounter::computeProbes(int &maxProbes, float &averageProbes)
+{
+    long long totalProbes = 0;
+    int count = 0;
+    maxProbes = 0;
+    visitInOrder([&](std::string_view, int, int depth)
+                 {
+                     int probes = depth + 1; // One probe per node visited on the way down
+                     count++;
+                     totalProbes += probes;
+                     maxProbes = probes > maxProbes ? probes : maxProbes;
+                 });
+    averageProbes = count == 0 ? 0 : static_cast<float>(totalProbes) / count;
+}
+
+// Documented in TextAnalysisRadix.h
+float RadixWordCounter::computeWeightedProbes()
+{
+    long long weightedTotal = 0, occurrences = 0;
+    visitInOrder([&](std::string_view, int frequency, int depth)
+                 {
+                     weightedTotal += static_cast<long long>(frequency) * (depth + 1);
+                     occurrences += frequency;
+                 });
+    return occurrences == 0 ? 0 : static_cast<float>(static_cast<double>(weightedTotal) / occurrences);
+}
+
+// Documented in TextAnalysisRadix.h
+void RadixWordCounter::collectInOrder(std::vector<WordCount> &out) const
+{
+    copies.clear(); // The previous collection's words are no longer needed
+    out.reserve(out.size() + wordCount);
+    visitInOrder([this, &out](std::string_view word, int frequency, int)
+                 { out.push_back(WordCount{copies.intern(word), frequency}); });
+}
+
+// Documented in TextAnalysisRadix.h
+void RadixWordCounter::collectReport(std::vector<ReportEntry> &entries, ProbeStatistics &statistics)
+{
+    long long totalProbes = 0, weightedTotal = 0, occurrences = 0;
+    int count = 0;
+    statistics.maxProbes = 0;
+    copies.clear(); // The previous collection's words are no longer needed
+    entries.reserve(entries.size() + wordCount);
+    visitInOrder([&](std::string_view word, int frequency, int depth)
+                 {
+                     int probes = depth + 1;
+                     count++;
+                     totalProbes += probes;
+                     weightedTotal += static_cast<long long>(frequency) * probes;
+                     occurrences += frequency;
+                     statistics.maxProbes = probes > statistics.maxProbes ? probes : statistics.maxProbes;
+                     entries.push_back(ReportEntry{copies.intern(word), frequency, depth});
+                 });
+    statistics.averageProbes = count == 0 ? 0 : static_cast<float>(totalProbes) / count;
+    statistics.weightedProbes =
+        occurrences == 0 ? 0 : static_cast<float>(static_cast<double>(weightedTotal) / occurrences);
+}
+
+// Documented in TextAnalysisRadix.h
+void RadixWordCounter::visitReportLines(const ReportLineVisitor &visit)
+{
+    visitInOrder([&visit](std::string_view word, int frequency, int depth) { visit(word, frequency, depth); });
+}
+
+// Documented in TextAnalysisRadix.h
+void RadixWordCounter::buildFromSorted(const std::vector<WordCount> &sortedWords)
+{
+    for (const WordCount &entry : sortedWords)
+    {
+        add(entry.word, entry.frequency);
+    }
+}
+
+// Documented in TextAnalysisRadix.h
+std::size_t RadixWordCounter::distinctWords() const
+{
+    return wordCount;
+}
+
+// Documented in TextAnalysisRadix.h
+ArenaStats RadixWordCounter::getArenaStats() const
+{
+    return poolStats; // The words copied out by collections are scratch space, not part of the trie
+}
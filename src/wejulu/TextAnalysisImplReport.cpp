@@ -0,0 +1,152 @@
+// TextAnalysisImplReport.cpp
+
+#include "TextAnalysisReport.h"
+#include <cerrno>
+#include <cmath>
+#include <cstdio>
+#include <fcntl.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+// Documented in TextAnalysisReport.h
+void ReportBuffer::appendInteger(long long value)
+{
+    char digits[24];
+    char *end = digits + sizeof(digits);
+    char *cursor = end;
+    // Work on the magnitude as unsigned so that the most negative value does not overflow
+    unsigned long long magnitude = value < 0 ? 0ULL - static_cast<unsigned long long>(value)
+                                             : static_cast<unsigned long long>(value);
+    do
+    {
+        *--cursor = static_cast<char>('0' + magnitude % 10);
+        magnitude /= 10;
+    } while (magnitude != 0);
+    if (value < 0)
+    {
+        *--cursor = '-';
+    }
+    data.append(cursor, static_cast<std::size_t>(end - cursor));
+}
+
+// Documented in TextAnalysisReport.h
+void ReportBuffer::appendFixed1(float value)
+{
+    // A float has a 24-bit significand, so value * 10 is exact in a double and nearbyint (round half to even, the
+    // default rounding mode) rounds it exactly as printf does. Values out of that range take the slow path.
+    double scaled = static_cast<double>(value) * 10.0;
+    if (!(std::fabs(scaled) < 1e17))
+    {
+        char text[64];
+        int length = std::snprintf(text, sizeof(text), "%.1f", static_cast<double>(value));
+        data.append(text, static_cast<std::size_t>(length));
+        return;
+    }
+    long long tenths = static_cast<long long>(std::nearbyint(scaled));
+    if (tenths < 0 || (tenths == 0 && std::signbit(value)))
+    {
+        data += '-';
+        tenths = -tenths;
+    }
+    appendInteger(tenths / 10);
+    data += '.';
+    data += static_cast<char>('0' + tenths % 10);
+}
+
+// Initialize a writer without an open file
+ReportWriter::ReportWriter() : fd(-1), failed(false)
+{
+    data.reserve(2 * flushThreshold);
+}
+
+// Flush whatever is left when the writer goes away
+ReportWriter::~ReportWriter()
+{
+    close();
+}
+
+// Documented in TextAnalysisReport.h
+bool ReportWriter::open(const std::string &fileName, bool append)
+{
+    close();
+    fd = ::open(fileName.c_str(), O_WRONLY | O_CREAT | (append ? O_APPEND : O_TRUNC), 0644);
+    failed = fd < 0;
+    return fd >= 0;
+}
+
+// Documented in TextAnalysisReport.h
+bool ReportWriter::writeOut(std::string_view extra)
+{
+    if (fd < 0 || failed)
+    {
+        data.clear();
+        return false;
+    }
+
+    struct iovec parts[2];
+    parts[0].iov_base = const_cast<char *>(data.data());
+    parts[0].iov_len = data.size();
+    parts[1].iov_base = const_cast<char *>(extra.data());
+    parts[1].iov_len = extra.size();
+    int first = 0;
+    while (first < 2)
+    {
+        ssize_t written = writev(fd, parts + first, 2 - first);
+        if (written < 0)
+        {
+            if (errno == EINTR)
+            {
+                continue;
+            }
+            failed = true;
+            break;
+        }
+        // Skip what was written, a short write can end in the middle of either part
+        std::size_t remaining = static_cast<std::size_t>(written);
+        while (first < 2 && remaining >= parts[first].iov_len)
+        {
+            remaining -= parts[first].iov_len;
+            first++;
+        }
+        if (first < 2)
+        {
+            parts[first].iov_base = static_cast<char *>(parts[first].iov_base) + remaining;
+            parts[first].iov_len -= remaining;
+        }
+    }
+    data.clear();
+    return !failed;
+}
+
+// Documented in TextAnalysisReport.h
+bool ReportWriter::flush()
+{
+    if (data.empty())
+    {
+        return !failed;
+    }
+    return writeOut(std::string_view());
+}
+
+// Documented in TextAnalysisReport.h
+bool ReportWriter::writeBlock(std::string_view block)
+{
+    if (data.size() + block.size() < flushThreshold)
+    {
+        append(block);
+        return !failed;
+    }
+    return writeOut(block);
+}
+
+// Documented in TextAnalysisReport.h
+bool ReportWriter::close()
+{
+    bool success = flush();
+    if (fd >= 0)
+    {
+        success = ::close(fd) == 0 && success;
+        fd = -1;
+    }
+    return success;
+}
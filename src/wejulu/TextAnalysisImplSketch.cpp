@@ -0,0 +1,306 @@
+// TextAnalysisImplSketch.cpp
+
+#include "TextAnalysisSketch.h"
+#include <algorithm>
+#include <cstring>
+
+// Table entry marking an empty slot
+static const std::uint32_t noCounter = 0xFFFFFFFFu;
+
+// Documented in TextAnalysisSketch.h
+std::uint64_t hashStreamWord(std::string_view word)
+{
+    // FNV-1a, then the SplitMix64 finalizer so that every bit of the result depends on every byte of the word
+    std::uint64_t hash = 14695981039346656037ULL;
+    for (unsigned char c : word)
+    {
+        hash = (hash ^ c) * 1099511628211ULL;
+    }
+    hash = (hash ^ (hash >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    hash = (hash ^ (hash >> 27)) * 0x94D049BB133111EBULL;
+    return hash ^ (hash >> 31);
+}
+
+// Returns the column a hash maps to in a row of the sketch; the rows use independent-enough double hashing
+static std::size_t sketchColumn(std::uint64_t hash, std::size_t row, std::size_t mask)
+{
+    std::uint64_t step = (hash >> 32) | 1;
+    return static_cast<std::size_t>((hash & 0xFFFFFFFFu) + row * step) & mask;
+}
+
+// Initialize an empty sketch whose counters fit in the budget
+CountMinSketch::CountMinSketch(std::size_t bytes)
+{
+    std::size_t width = 1;
+    while (sketchDepth * width * 2 * sizeof(std::uint64_t) <= bytes)
+    {
+        width *= 2;
+    }
+    mask = width - 1;
+    cells.assign(sketchDepth * width, 0);
+}
+
+// Documented in TextAnalysisSketch.h
+std::uint64_t CountMinSketch::add(std::uint64_t hash)
+{
+    std::uint64_t *cell[sketchDepth];
+    std::uint64_t minimum = UINT64_MAX;
+    for (std::size_t row = 0; row < sketchDepth; row++)
+    {
+        cell[row] = &cells[row * width() + sketchColumn(hash, row, mask)];
+        minimum = *cell[row] < minimum ? *cell[row] : minimum;
+    }
+    // Conservative update: a counter above the new estimate already covers this occurrence
+    std::uint64_t updated = minimum + 1;
+    for (std::uint64_t *counter : cell)
+    {
+        *counter = *counter < updated ? updated : *counter;
+    }
+    return updated;
+}
+
+// Documented in TextAnalysisSketch.h
+std::uint64_t CountMinSketch::estimate(std::uint64_t hash) const
+{
+    std::uint64_t minimum = UINT64_MAX;
+    for (std::size_t row = 0; row < sketchDepth; row++)
+    {
+        std::uint64_t value = cells[row * width() + sketchColumn(hash, row, mask)];
+        minimum = value < minimum ? value : minimum;
+    }
+    return minimum;
+}
+
+// Initialize an empty tracker, giving half the budget to the sketch and sizing the counters to the other half
+StreamingTopK::StreamingTopK(std::size_t memoryBudget, std::size_t topCount)
+    : sketch(memoryBudget / 2), used(0), topCount(topCount), words(0)
+{
+    // The table is the largest power of two that leaves room for half as many counters; counters then fill the
+    // rest of the budget, up to three quarters of the table so that probe runs stay short
+    const std::size_t budget = memoryBudget - memoryBudget / 2;
+    const std::size_t perCounter = sizeof(StreamCounter) + sizeof(std::uint32_t); // The counter and its heap entry
+    std::size_t tableSize = 2;
+    while ((tableSize * 2) * sizeof(std::uint32_t) + tableSize * perCounter <= budget)
+    {
+        tableSize *= 2;
+    }
+    std::size_t tableBytes = tableSize * sizeof(std::uint32_t);
+    std::size_t capacity = budget > tableBytes ? (budget - tableBytes) / perCounter : 0;
+    capacity = std::max<std::size_t>(std::min(capacity, tableSize / 4 * 3), 1);
+
+    counters.resize(capacity);
+    heap.resize(capacity);
+    table.assign(tableSize, noCounter);
+}
+
+// Documented in TextAnalysisSketch.h
+std::size_t StreamingTopK::findSlot(std::string_view word, std::uint64_t hash) const
+{
+    const std::size_t mask = table.size() - 1;
+    for (std::size_t slot = static_cast<std::size_t>(hash >> 20) & mask;; slot = (slot + 1) & mask)
+    {
+        std::uint32_t index = table[slot];
+        if (index == noCounter)
+        {
+            return slot;
+        }
+        const StreamCounter &counter = counters[index];
+        if (counter.hash == hash && counter.length == word.size() &&
+            std::memcmp(counter.word, word.data(), word.size()) == 0)
+        {
+            return slot;
+        }
+    }
+}
+
+// Documented in TextAnalysisSketch.h
+void StreamingTopK::eraseSlot(std::size_t slot)
+{
+    // Backward-shift deletion: pull every later entry of the run into the hole unless its home lies after the hole
+    const std::size_t mask = table.size() - 1;
+    std::size_t hole = slot;
+    for (std::size_t next = (hole + 1) & mask; table[next] != noCounter; next = (next + 1) & mask)
+    {
+        std::size_t home = static_cast<std::size_t>(counters[table[next]].hash >> 20) & mask;
+        if (((next - home) & mask) >= ((next - hole) & mask))
+        {
+            table[hole] = table[next];
+            hole = next;
+        }
+    }
+    table[hole] = noCounter;
+}
+
+// Documented in TextAnalysisSketch.h
+void StreamingTopK::siftDown(std::size_t position)
+{
+    std::uint32_t index = heap[position];
+    std::int64_t count = counters[index].count;
+    while (true)
+    {
+        std::size_t child = 2 * position + 1;
+        if (child >= used)
+        {
+            break;
+        }
+        if (child + 1 < used && counters[heap[child + 1]].count < counters[heap[child]].count)
+        {
+            child++;
+        }
+        if (counters[heap[child]].count >= count)
+        {
+            break;
+        }
+        heap[position] = heap[child];
+        counters[heap[position]].heapPosition = static_cast<std::uint32_t>(position);
+        position = child;
+    }
+    heap[position] = index;
+    counters[index].heapPosition = static_cast<std::uint32_t>(position);
+}
+
+// Documented in TextAnalysisSketch.h
+void StreamingTopK::siftUp(std::size_t position)
+{
+    std::uint32_t index = heap[position];
+    std::int64_t count = counters[index].count;
+    while (position > 0)
+    {
+        std::size_t parent = (position - 1) / 2;
+        if (counters[heap[parent]].count <= count)
+        {
+            break;
+        }
+        heap[position] = heap[parent];
+        counters[heap[position]].heapPosition = static_cast<std::uint32_t>(position);
+        position = parent;
+    }
+    heap[position] = index;
+    counters[index].heapPosition = static_cast<std::uint32_t>(position);
+}
+
+// Documented in TextAnalysisSketch.h
+void StreamingTopK::consumeToken(std::string_view word)
+{
+    words++;
+    std::uint64_t hash = hashStreamWord(word);
+    sketch.add(hash);
+    if (word.size() > streamWordLength)
+    {
+        return;
+    }
+
+    std::size_t slot = findSlot(word, hash);
+    std::uint32_t index = table[slot];
+    if (index != noCounter)
+    {
+        counters[index].count++;
+        siftDown(counters[index].heapPosition);
+        return;
+    }
+
+    std::int64_t inherited = 0;
+    if (used < counters.size())
+    {
+        // A free counter joins the heap as a leaf and moves up past larger counts once it is filled in
+        index = static_cast<std::uint32_t>(used);
+        heap[used] = index;
+        counters[index].heapPosition = static_cast<std::uint32_t>(used);
+        used++;
+    }
+    else
+    {
+        // Take over the counter with the smallest count; its old word leaves the table first
+        index = heap[0];
+        inherited = counters[index].count;
+        eraseSlot(findSlot(std::string_view(counters[index].word, counters[index].length), counters[index].hash));
+        slot = findSlot(word, hash); // The deletion may have moved the empty slot
+    }
+
+    StreamCounter &counter = counters[index];
+    counter.hash = hash;
+    counter.count = inherited + 1;
+    counter.error = inherited;
+    counter.length = static_cast<std::uint32_t>(word.size());
+    std::memcpy(counter.word, word.data(), word.size());
+    table[slot] = index;
+    if (inherited == 0)
+    {
+        siftUp(counter.heapPosition);
+    }
+    else
+    {
+        siftDown(counter.heapPosition);
+    }
+}
+
+// Documented in TextAnalysisSketch.h
+std::int64_t StreamingTopK::upperBound(const StreamCounter &counter) const
+{
+    std::uint64_t estimate = sketch.estimate(counter.hash);
+    return static_cast<std::uint64_t>(counter.count) < estimate ? counter.count
+                                                                : static_cast<std::int64_t>(estimate);
+}
+
+// Documented in TextAnalysisSketch.h
+bool StreamingTopK::bounds(std::string_view word, std::int64_t &lower, std::int64_t &upper) const
+{
+    if (word.size() > streamWordLength)
+    {
+        return false;
+    }
+    std::uint32_t index = table[findSlot(word, hashStreamWord(word))];
+    if (index == noCounter)
+    {
+        return false;
+    }
+    lower = counters[index].count - counters[index].error;
+    upper = upperBound(counters[index]);
+    return true;
+}
+
+// Documented in TextAnalysisSketch.h
+void StreamingTopK::writeSnapshot(ReportBuffer &out, std::string_view source) const
+{
+    // Rank the monitored words by their reported count, alphabetically among equal counts
+    struct Ranked
+    {
+        std::int64_t upper;
+        std::int64_t lower;
+        std::string_view word;
+    };
+    std::vector<Ranked> ranked;
+    ranked.reserve(used);
+    for (std::size_t i = 0; i < used; i++)
+    {
+        const StreamCounter &counter = counters[i];
+        ranked.push_back(Ranked{upperBound(counter), counter.count - counter.error,
+                                std::string_view(counter.word, counter.length)});
+    }
+    std::size_t listed = std::min(topCount, ranked.size());
+    std::partial_sort(ranked.begin(), ranked.begin() + listed, ranked.end(),
+                      [](const Ranked &a, const Ranked &b)
+                      { return a.upper != b.upper ? a.upper > b.upper : a.word < b.word; });
+
+    // No monitored count can exceed its word's true count by more than the smallest count once all are in use
+    std::int64_t maximumOverestimate = used == counters.size() && used > 0 ? counters[heap[0]].count : 0;
+
+    out.append(source);
+    out.append('\n');
+    out.append("Words counted: ");
+    out.appendInteger(static_cast<long long>(words));
+    out.append('\n');
+    out.append("Maximum overestimate: ");
+    out.appendInteger(maximumOverestimate);
+    out.append('\n');
+    for (std::size_t i = 0; i < listed; i++)
+    {
+        out.append(ranked[i].word);
+        out.append(' ');
+        out.appendInteger(ranked[i].upper);
+        out.append(" (");
+        out.appendInteger(ranked[i].upper - ranked[i].lower);
+        out.append(")\n");
+    }
+    out.append("--------------------\n");
+}
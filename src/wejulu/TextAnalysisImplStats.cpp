@@ -0,0 +1,156 @@
+// TextAnalysisImplStats.cpp
+
+#include "TextAnalysisStats.h"
+#include <cstdio>
+#include <fstream>
+
+// Documented in TextAnalysisStats.h
+void FileStats::add(const FileStats &other)
+{
+    seconds.ingest += other.seconds.ingest;
+    seconds.insert += other.seconds.insert;
+    seconds.merge += other.seconds.merge;
+    seconds.optimize += other.seconds.optimize;
+    seconds.report += other.seconds.report;
+    seconds.cache += other.seconds.cache;
+    seconds.total += other.seconds.total;
+    bytesRead += other.bytesRead;
+    tokens += other.tokens;
+    distinctWords += other.distinctWords;
+    engineCounters = engineCounters || other.engineCounters;
+    engine.comparisons += other.engine.comparisons;
+    engine.nodeAllocations += other.engine.nodeAllocations;
+    engine.peakDepth = other.engine.peakDepth > engine.peakDepth ? other.engine.peakDepth : engine.peakDepth;
+}
+
+// Formats a duration with microsecond resolution, independently of the stream state
+static std::string formatSeconds(double seconds)
+{
+    char text[32];
+    std::snprintf(text, sizeof(text), "%.6f", seconds);
+    return text;
+}
+
+// Quotes a string for JSON, escaping quotes, backslashes and control characters
+static std::string quoteJson(const std::string &text)
+{
+    std::string quoted = "\"";
+    for (unsigned char c : text)
+    {
+        if (c == '"' || c == '\\')
+        {
+            quoted += '\\';
+            quoted += static_cast<char>(c);
+        }
+        else if (c < 0x20)
+        {
+            char escape[8];
+            std::snprintf(escape, sizeof(escape), "\\u%04x", c);
+            quoted += escape;
+        }
+        else
+        {
+            quoted += static_cast<char>(c);
+        }
+    }
+    return quoted + "\"";
+}
+
+// Quotes a CSV field when it contains a separator, a quote or a line break
+static std::string quoteCsv(const std::string &text)
+{
+    if (text.find_first_of(",\"\r\n") == std::string::npos)
+    {
+        return text;
+    }
+    std::string quoted = "\"";
+    for (char c : text)
+    {
+        quoted += c;
+        if (c == '"')
+        {
+            quoted += '"';
+        }
+    }
+    return quoted + "\"";
+}
+
+// Writes one record as a JSON object on a single line
+static void writeJsonRecord(std::ostream &out, const FileStats &stats)
+{
+    const PhaseTimes &t = stats.seconds;
+    out << "{\"file\": " << quoteJson(stats.fileName) << ", \"outcome\": " << quoteJson(stats.outcome)
+        << ", \"seconds\": {\"total\": " << formatSeconds(t.total) << ", \"ingest\": " << formatSeconds(t.ingest)
+        << ", \"tokenize\": " << formatSeconds(t.ingest > t.insert ? t.ingest - t.insert : 0)
+        << ", \"insert\": " << formatSeconds(t.insert) << ", \"merge\": " << formatSeconds(t.merge)
+        << ", \"optimize\": " << formatSeconds(t.optimize) << ", \"report\": " << formatSeconds(t.report)
+        << ", \"cache\": " << formatSeconds(t.cache) << "}, \"bytesRead\": " << stats.bytesRead
+        << ", \"tokens\": " << stats.tokens << ", \"distinctWords\": " << stats.distinctWords;
+    if (stats.engineCounters)
+    {
+        out << ", \"comparisons\": " << stats.engine.comparisons << ", \"nodeAllocations\": "
+            << stats.engine.nodeAllocations << ", \"peakDepth\": " << stats.engine.peakDepth << "}";
+    }
+    else
+    {
+        out << ", \"comparisons\": null, \"nodeAllocations\": null, \"peakDepth\": null}";
+    }
+}
+
+// Writes one record as a CSV row
+static void writeCsvRecord(std::ostream &out, const std::string &name, const FileStats &stats)
+{
+    const PhaseTimes &t = stats.seconds;
+    out << quoteCsv(name) << ',' << stats.outcome << ',' << formatSeconds(t.total) << ',' << formatSeconds(t.ingest)
+        << ',' << formatSeconds(t.ingest > t.insert ? t.ingest - t.insert : 0) << ',' << formatSeconds(t.insert)
+        << ',' << formatSeconds(t.merge) << ',' << formatSeconds(t.optimize) << ',' << formatSeconds(t.report) << ','
+        << formatSeconds(t.cache) << ',' << stats.bytesRead << ',' << stats.tokens << ',' << stats.distinctWords
+        << ',';
+    if (stats.engineCounters)
+    {
+        out << stats.engine.comparisons << ',' << stats.engine.nodeAllocations << ',' << stats.engine.peakDepth;
+    }
+    else
+    {
+        out << ",,"; // Engines without counters leave the fields empty
+    }
+    out << '\n';
+}
+
+// Documented in TextAnalysisStats.h
+bool writeStatsSidecar(const std::string &fileName, const std::vector<FileStats> &files, const FileStats &aggregate,
+                       double wallSeconds)
+{
+    std::ofstream out(fileName);
+    if (!out.is_open())
+    {
+        return false;
+    }
+
+    bool csv = fileName.size() >= 4 && fileName.compare(fileName.size() - 4, 4, ".csv") == 0;
+    if (csv)
+    {
+        out << "file,outcome,total_s,ingest_s,tokenize_s,insert_s,merge_s,optimize_s,report_s,cache_s,bytes_read,"
+               "tokens,distinct_words,comparisons,node_allocations,peak_depth\n";
+        for (const FileStats &stats : files)
+        {
+            writeCsvRecord(out, stats.fileName, stats);
+        }
+        writeCsvRecord(out, "TOTAL", aggregate);
+    }
+    else
+    {
+        out << "{\n  \"files\": [";
+        for (std::size_t i = 0; i < files.size(); i++)
+        {
+            out << (i == 0 ? "\n    " : ",\n    ");
+            writeJsonRecord(out, files[i]);
+        }
+        out << "\n  ],\n  \"aggregate\": ";
+        writeJsonRecord(out, aggregate);
+        out << ",\n  \"filesAnalyzed\": " << files.size() << ",\n  \"wallSeconds\": " << formatSeconds(wallSeconds)
+            << "\n}\n";
+    }
+    out.close();
+    return !out.fail();
+}
@@ -0,0 +1,640 @@
+// TextAnalysisImplTokenizer.cpp
+
+#include "TextAnalysisTokenizer.h"
+#include <cctype>
+#include <cstdint>
+#include <fstream>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#if defined(__SSE2__)
+#include <immintrin.h>
+#endif
+
+// Bytes of a file mapped at a time; a multiple of every common page size
+static const std::size_t mappingWindow = 64 * 1024 * 1024;
+
+// Bytes read at a time when an input cannot be mapped
+static const std::size_t readBufferSize = 1024 * 1024;
+
+// Bytes classified per kernel call; the masks for one stretch stay in L1
+static const std::size_t stretchSize = 4096;
+static const std::size_t masksPerStretch = stretchSize / 64;
+
+// Character class bits used by the tokenizer
+static const unsigned char wordCharacter = 1;  // Letter, digit or hyphen
+static const unsigned char upperCharacter = 2; // Uppercase letter
+
+/**
+ * Lookup table classifying every byte value. It mirrors std::isalnum and std::isupper in the "C" locale the
+ * program runs in, without the per-call locale lookup.
+ */
+struct CharacterTable
+{
+    unsigned char classOf[256];
+
+    CharacterTable()
+    {
+        for (int c = 0; c < 256; c++)
+        {
+            bool upper = c >= 'A' && c <= 'Z';
+            bool alnum = upper || (c >= 'a' && c <= 'z') || (c >= '0' && c <= '9');
+            classOf[c] = (alnum || c == '-' ? wordCharacter : 0) | (upper ? upperCharacter : 0);
+        }
+    }
+};
+
+static const CharacterTable characterTable;
+
+// Whether a byte belongs to a word
+static inline bool isWordCharacter(char c)
+{
+    return characterTable.classOf[static_cast<unsigned char>(c)] & wordCharacter;
+}
+
+/**
+ * Classification kernel: for each group of 64 input bytes, sets bit i of wordMasks[g] when byte g*64+i belongs to a
+ * word and bit i of upperMasks[g] when it is an uppercase letter. Bits past the end of the input are left clear.
+ */
+typedef void (*ClassifyFunction)(const char *data, std::size_t length, std::uint64_t *wordMasks,
+                                 std::uint64_t *upperMasks);
+
+// Lowercasing kernel: copies length bytes from source to destination, folding uppercase ASCII letters
+typedef void (*LowercaseFunction)(char *destination, const char *source, std::size_t length);
+
+// Documented at ClassifyFunction
+static void classifyScalar(const char *data, std::size_t length, std::uint64_t *wordMasks, std::uint64_t *upperMasks)
+{
+    for (std::size_t group = 0; group * 64 < length; group++)
+    {
+        std::uint64_t word = 0, upper = 0;
+        std::size_t count = length - group * 64 < 64 ? length - group * 64 : 64;
+        for (std::size_t i = 0; i < count; i++)
+        {
+            unsigned char characterClass = characterTable.classOf[static_cast<unsigned char>(data[group * 64 + i])];
+            word |= static_cast<std::uint64_t>(characterClass & wordCharacter) << i;
+            upper |= static_cast<std::uint64_t>((characterClass & upperCharacter) >> 1) << i;
+        }
+        wordMasks[group] = word;
+        upperMasks[group] = upper;
+    }
+}
+
+// Documented at LowercaseFunction
+static void lowercaseScalar(char *destination, const char *source, std::size_t length)
+{
+    for (std::size_t i = 0; i < length; i++)
+    {
+        unsigned char c = static_cast<unsigned char>(source[i]);
+        destination[i] = static_cast<char>(characterTable.classOf[c] & upperCharacter ? c + ('a' - 'A') : c);
+    }
+}
+
+#if defined(__SSE2__)
+/*
+ * The vector kernels test byte ranges with one signed comparison each: adding (0x80 - low) moves the range
+ * [low, low + size) to the bottom of the signed byte range, so "in range" becomes "less than -128 + size".
+ * Letters are detected case-insensitively by setting bit 0x20 first.
+ */
+
+// Documented at ClassifyFunction
+static void classifySSE2(const char *data, std::size_t length, std::uint64_t *wordMasks, std::uint64_t *upperMasks)
+{
+    const __m128i caseBit = _mm_set1_epi8(0x20);
+    const __m128i letterBias = _mm_set1_epi8(static_cast<char>(0x80 - 'a'));
+    const __m128i upperBias = _mm_set1_epi8(static_cast<char>(0x80 - 'A'));
+    const __m128i digitBias = _mm_set1_epi8(static_cast<char>(0x80 - '0'));
+    const __m128i letterLimit = _mm_set1_epi8(static_cast<char>(-128 + 26));
+    const __m128i digitLimit = _mm_set1_epi8(static_cast<char>(-128 + 10));
+    const __m128i hyphen = _mm_set1_epi8('-');
+
+    std::size_t fullGroups = length / 64;
+    for (std::size_t group = 0; group < fullGroups; group++)
+    {
+        std::uint64_t word = 0, upper = 0;
+        for (int lane = 0; lane < 4; lane++)
+        {
+            __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i *>(data + group * 64 + lane * 16));
+            __m128i letter = _mm_cmplt_epi8(_mm_add_epi8(_mm_or_si128(bytes, caseBit), letterBias), letterLimit);
+            __m128i digit = _mm_cmplt_epi8(_mm_add_epi8(bytes, digitBias), digitLimit);
+            __m128i isUpper = _mm_cmplt_epi8(_mm_add_epi8(bytes, upperBias), letterLimit);
+            __m128i isWord = _mm_or_si128(_mm_or_si128(letter, digit), _mm_cmpeq_epi8(bytes, hyphen));
+            word |= static_cast<std::uint64_t>(static_cast<unsigned>(_mm_movemask_epi8(isWord))) << (lane * 16);
+            upper |= static_cast<std::uint64_t>(static_cast<unsigned>(_mm_movemask_epi8(isUpper))) << (lane * 16);
+        }
+        wordMasks[group] = word;
+        upperMasks[group] = upper;
+    }
+    // The last partial group is too short for full vector loads
+    if (length % 64 != 0)
+    {
+        classifyScalar(data + fullGroups * 64, length % 64, wordMasks + fullGroups, upperMasks + fullGroups);
+    }
+}
+
+// Documented at LowercaseFunction
+static void lowercaseSSE2(char *destination, const char *source, std::size_t length)
+{
+    const __m128i upperBias = _mm_set1_epi8(static_cast<char>(0x80 - 'A'));
+    const __m128i letterLimit = _mm_set1_epi8(static_cast<char>(-128 + 26));
+    const __m128i caseBit = _mm_set1_epi8(0x20);
+    std::size_t i = 0;
+    for (; i + 16 <= length; i += 16)
+    {
+        __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i *>(source + i));
+        __m128i isUpper = _mm_cmplt_epi8(_mm_add_epi8(bytes, upperBias), letterLimit);
+        bytes = _mm_or_si128(bytes, _mm_and_si128(isUpper, caseBit));
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(destination + i), bytes);
+    }
+    lowercaseScalar(destination + i, source + i, length - i);
+}
+
+// Documented at ClassifyFunction
+__attribute__((target("avx2"))) static void classifyAVX2(const char *data, std::size_t length,
+                                                         std::uint64_t *wordMasks, std::uint64_t *upperMasks)
+{
+    const __m256i caseBit = _mm256_set1_epi8(0x20);
+    const __m256i letterBias = _mm256_set1_epi8(static_cast<char>(0x80 - 'a'));
+    const __m256i upperBias = _mm256_set1_epi8(static_cast<char>(0x80 - 'A'));
+    const __m256i digitBias = _mm256_set1_epi8(static_cast<char>(0x80 - '0'));
+    const __m256i letterLimit = _mm256_set1_epi8(static_cast<char>(-128 + 26));
+    const __m256i digitLimit = _mm256_set1_epi8(static_cast<char>(-128 + 10));
+    const __m256i hyphen = _mm256_set1_epi8('-');
+
+    std::size_t fullGroups = length / 64;
+    for (std::size_t group = 0; group < fullGroups; group++)
+    {
+        std::uint64_t word = 0, upper = 0;
+        for (int lane = 0; lane < 2; lane++)
+        {
+            __m256i bytes = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(data + group * 64 + lane * 32));
+            // AVX2 has no signed "less than", so compare the limit against the biased value instead
+            __m256i letter = _mm256_cmpgt_epi8(letterLimit, _mm256_add_epi8(_mm256_or_si256(bytes, caseBit), letterBias));
+            __m256i digit = _mm256_cmpgt_epi8(digitLimit, _mm256_add_epi8(bytes, digitBias));
+            __m256i isUpper = _mm256_cmpgt_epi8(letterLimit, _mm256_add_epi8(bytes, upperBias));
+            __m256i isWord = _mm256_or_si256(_mm256_or_si256(letter, digit), _mm256_cmpeq_epi8(bytes, hyphen));
+            word |= static_cast<std::uint64_t>(static_cast<unsigned>(_mm256_movemask_epi8(isWord))) << (lane * 32);
+            upper |= static_cast<std::uint64_t>(static_cast<unsigned>(_mm256_movemask_epi8(isUpper))) << (lane * 32);
+        }
+        wordMasks[group] = word;
+        upperMasks[group] = upper;
+    }
+    if (length % 64 != 0)
+    {
+        classifyScalar(data + fullGroups * 64, length % 64, wordMasks + fullGroups, upperMasks + fullGroups);
+    }
+}
+
+// Documented at LowercaseFunction
+__attribute__((target("avx2"))) static void lowercaseAVX2(char *destination, const char *source, std::size_t length)
+{
+    const __m256i upperBias = _mm256_set1_epi8(static_cast<char>(0x80 - 'A'));
+    const __m256i letterLimit = _mm256_set1_epi8(static_cast<char>(-128 + 26));
+    const __m256i caseBit = _mm256_set1_epi8(0x20);
+    std::size_t i = 0;
+    for (; i + 32 <= length; i += 32)
+    {
+        __m256i bytes = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(source + i));
+        __m256i isUpper = _mm256_cmpgt_epi8(letterLimit, _mm256_add_epi8(bytes, upperBias));
+        bytes = _mm256_or_si256(bytes, _mm256_and_si256(isUpper, caseBit));
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(destination + i), bytes);
+    }
+    lowercaseSSE2(destination + i, source + i, length - i);
+}
+#endif // __SSE2__
+
+// Kernel currently in use, chosen on first use by selectTokenizerKernel(TokenizerKernel::Auto)
+struct KernelSelection
+{
+    TokenizerKernel kernel;
+    ClassifyFunction classify;
+    LowercaseFunction lowercase;
+
+    KernelSelection() : kernel(TokenizerKernel::Scalar), classify(classifyScalar), lowercase(lowercaseScalar)
+    {
+#if defined(__SSE2__)
+        kernel = TokenizerKernel::SSE2;
+        classify = classifySSE2;
+        lowercase = lowercaseSSE2;
+        if (__builtin_cpu_supports("avx2"))
+        {
+            kernel = TokenizerKernel::AVX2;
+            classify = classifyAVX2;
+            lowercase = lowercaseAVX2;
+        }
+#endif
+    }
+};
+
+static KernelSelection kernelSelection;
+
+// Documented in TextAnalysisTokenizer.h
+bool selectTokenizerKernel(TokenizerKernel kernel)
+{
+    switch (kernel)
+    {
+    case TokenizerKernel::Auto:
+        kernelSelection = KernelSelection();
+        return true;
+    case TokenizerKernel::Scalar:
+        kernelSelection.kernel = kernel;
+        kernelSelection.classify = classifyScalar;
+        kernelSelection.lowercase = lowercaseScalar;
+        return true;
+#if defined(__SSE2__)
+    case TokenizerKernel::SSE2:
+        kernelSelection.kernel = kernel;
+        kernelSelection.classify = classifySSE2;
+        kernelSelection.lowercase = lowercaseSSE2;
+        return true;
+    case TokenizerKernel::AVX2:
+        if (!__builtin_cpu_supports("avx2"))
+        {
+            return false;
+        }
+        kernelSelection.kernel = kernel;
+        kernelSelection.classify = classifyAVX2;
+        kernelSelection.lowercase = lowercaseAVX2;
+        return true;
+#endif
+    default:
+        return false;
+    }
+}
+
+// Documented in TextAnalysisTokenizer.h
+TokenizerKernel activeTokenizerKernel()
+{
+    return kernelSelection.kernel;
+}
+
+// Documented in TextAnalysisTokenizer.h
+const char *tokenizerKernelName(TokenizerKernel kernel)
+{
+    switch (kernel)
+    {
+    case TokenizerKernel::Auto:
+        return "auto";
+    case TokenizerKernel::Scalar:
+        return "scalar";
+    case TokenizerKernel::SSE2:
+        return "sse2";
+    case TokenizerKernel::AVX2:
+        return "avx2";
+    }
+    return "unknown";
+}
+
+// Bits [from, to) of a 64-bit mask, with 0 <= from <= to <= 64
+static inline std::uint64_t bitRange(unsigned from, unsigned to)
+{
+    std::uint64_t below = to == 64 ? ~std::uint64_t(0) : (std::uint64_t(1) << to) - 1;
+    return below & ~((std::uint64_t(1) << from) - 1);
+}
+
+// Initialize a tokenizer with nothing pending
+Tokenizer::Tokenizer(TokenSink &sink) : sink(sink) {}
+
+// Documented in TextAnalysisTokenizer.h
+void Tokenizer::emit(std::string_view word, bool hasUpper)
+{
+    // Words without uppercase letters are passed on in place, the rest are folded into the scratch buffer
+    if (hasUpper)
+    {
+        folded.resize(word.size());
+        kernelSelection.lowercase(&folded[0], word.data(), word.size());
+        word = folded;
+    }
+    // Check for trailing 's in words and remove it. Apostrophes end a word, so like the line-based splitter this
+    // never fires in practice and "ejulu's" yields "ejulu" followed by "s"; it is kept so both paths share a rule set.
+    if (word.size() > 2 && word.substr(word.size() - 2) == "'s")
+    {
+        word = word.substr(0, word.size() - 2);
+    }
+    sink.consumeToken(word);
+}
+
+// Documented in TextAnalysisTokenizer.h
+void Tokenizer::scan(const char *data, std::size_t position, std::size_t length)
+{
+    std::uint64_t wordMasks[masksPerStretch];
+    std::uint64_t upperMasks[masksPerStretch];
+    bool inWord = false;        // Whether the previous byte belonged to a word
+    bool wordHasUpper = false;  // Whether the current word contains uppercase letters so far
+    std::size_t wordStart = 0;  // Offset of the current word in the chunk
+
+    for (std::size_t stretch = position; stretch < length; stretch += stretchSize)
+    {
+        std::size_t stretchLength = length - stretch < stretchSize ? length - stretch : stretchSize;
+        kernelSelection.classify(data + stretch, stretchLength, wordMasks, upperMasks);
+
+        for (std::size_t group = 0; group * 64 < stretchLength; group++)
+        {
+            std::size_t groupStart = stretch + group * 64;
+            unsigned groupLength = stretchLength - group * 64 < 64 ? stretchLength - group * 64 : 64;
+            std::uint64_t word = wordMasks[group];
+            std::uint64_t upper = upperMasks[group];
+
+            // A word starts where a word byte follows a separator and ends where a separator follows a word byte
+            std::uint64_t previous = (word << 1) | (inWord ? 1 : 0);
+            std::uint64_t starts = word & ~previous;
+            std::uint64_t ends = ~word & previous & bitRange(0, groupLength);
+            std::uint64_t transitions = starts | ends;
+            unsigned segmentStart = 0; // First bit of the current word inside this group
+
+            while (transitions != 0)
+            {
+                unsigned bit = static_cast<unsigned>(__builtin_ctzll(transitions));
+                transitions &= transitions - 1;
+                if (starts & (std::uint64_t(1) << bit))
+                {
+                    inWord = true;
+                    wordHasUpper = false;
+                    wordStart = groupStart + bit;
+                    segmentStart = bit;
+                }
+                else
+                {
+                    wordHasUpper |= (upper & bitRange(segmentStart, bit)) != 0;
+                    emit(std::string_view(data + wordStart, groupStart + bit - wordStart), wordHasUpper);
+                    inWord = false;
+                }
+            }
+            if (inWord)
+            {
+                wordHasUpper |= (upper & bitRange(segmentStart, groupLength)) != 0;
+            }
+        }
+    }
+
+    // The word may continue in the next chunk, keep it until then
+    if (inWord)
+    {
+        pending.resize(length - wordStart);
+        kernelSelection.lowercase(&pending[0], data + wordStart, length - wordStart);
+    }
+}
+
+// Documented in TextAnalysisTokenizer.h
+void Tokenizer::feed(const char *data, std::size_t length)
+{
+    std::size_t position = 0;
+
+    // Complete a word carried over from the previous chunk
+    if (!pending.empty())
+    {
+        while (position < length && isWordCharacter(data[position]))
+        {
+            position++;
+        }
+        std::size_t pendingLength = pending.size();
+        pending.resize(pendingLength + position);
+        kernelSelection.lowercase(&pending[pendingLength], data, position);
+        if (position == length)
+        {
+            return; // The word continues into the next chunk as well
+        }
+        emit(pending, false);
+        pending.clear();
+    }
+
+    scan(data, position, length);
+}
+
+// Documented in TextAnalysisTokenizer.h
+void Tokenizer::finish()
+{
+    if (!pending.empty())
+    {
+        emit(pending, false);
+        pending.clear();
+    }
+}
+
+/**
+ * Feeds an input that cannot be mapped (a pipe, a FIFO, a terminal) to the tokenizer using buffered reads.
+ *
+ * @param fd The open file descriptor, positioned where reading starts.
+ * @param remaining The maximum number of bytes to read; reading also stops at the end of the input.
+ * @param tokenizer The tokenizer receiving the data.
+ * @return true if the input was read, false on a read error.
+ */
+static bool tokenizeStream(int fd, std::uint64_t remaining, Tokenizer &tokenizer)
+{
+    std::string buffer(readBufferSize, '\0');
+    while (remaining > 0)
+    {
+        std::size_t request = remaining < buffer.size() ? static_cast<std::size_t>(remaining) : buffer.size();
+        ssize_t bytesRead = read(fd, &buffer[0], request);
+        if (bytesRead == 0)
+        {
+            return true;
+        }
+        if (bytesRead < 0)
+        {
+            return false;
+        }
+        tokenizer.feed(buffer.data(), static_cast<std::size_t>(bytesRead));
+        remaining -= static_cast<std::uint64_t>(bytesRead);
+    }
+    return true;
+}
+
+/**
+ * Feeds a byte range of a regular file to the tokenizer by mapping successive windows of it, so that only one
+ * window needs to be resident at a time.
+ *
+ * @param fd The open file descriptor.
+ * @param begin The offset of the first byte to process.
+ * @param end The offset one past the last byte to process.
+ * @param tokenizer The tokenizer receiving the data.
+ * @return true if the whole range was processed, false on a read error.
+ */
+static bool tokenizeMapped(int fd, std::uint64_t begin, std::uint64_t end, Tokenizer &tokenizer)
+{
+    // Windows start at multiples of the window size, which keeps every mapping offset page-aligned
+    for (std::uint64_t offset = begin - begin % mappingWindow; offset < end; offset += mappingWindow)
+    {
+        std::size_t length = end - offset < mappingWindow ? static_cast<std::size_t>(end - offset) : mappingWindow;
+        std::size_t skip = begin > offset ? static_cast<std::size_t>(begin - offset) : 0;
+        void *mapping = mmap(nullptr, length, PROT_READ, MAP_PRIVATE, fd, static_cast<off_t>(offset));
+        if (mapping == MAP_FAILED)
+        {
+            // Some filesystems cannot be mapped, read the rest of the range instead
+            std::uint64_t resume = offset + skip;
+            return lseek(fd, static_cast<off_t>(resume), SEEK_SET) == static_cast<off_t>(resume) &&
+                   tokenizeStream(fd, end - resume, tokenizer);
+        }
+        madvise(mapping, length, MADV_SEQUENTIAL);
+        tokenizer.feed(static_cast<const char *>(mapping) + skip, length - skip);
+        munmap(mapping, length);
+    }
+    return true;
+}
+
+// Documented in TextAnalysisTokenizer.h
+bool tokenizeFile(const std::string &fileName, TokenSink &sink)
+{
+    int fd = open(fileName.c_str(), O_RDONLY);
+    if (fd < 0)
+    {
+        return false;
+    }
+
+    Tokenizer tokenizer(sink);
+    struct stat info;
+    bool success;
+    if (fstat(fd, &info) == 0 && S_ISREG(info.st_mode) && info.st_size > 0)
+    {
+        success = tokenizeMapped(fd, 0, static_cast<std::uint64_t>(info.st_size), tokenizer);
+    }
+    else
+    {
+        success = tokenizeStream(fd, UINT64_MAX, tokenizer);
+    }
+    close(fd);
+
+    if (success)
+    {
+        tokenizer.finish();
+    }
+    return success;
+}
+
+// Documented in TextAnalysisTokenizer.h
+bool tokenizeFileRange(const std::string &fileName, std::uint64_t begin, std::uint64_t end, TokenSink &sink)
+{
+    int fd = open(fileName.c_str(), O_RDONLY);
+    if (fd < 0)
+    {
+        return false;
+    }
+
+    Tokenizer tokenizer(sink);
+    bool success = tokenizeMapped(fd, begin, end, tokenizer);
+    close(fd);
+
+    if (success)
+    {
+        tokenizer.finish();
+    }
+    return success;
+}
+
+// Documented in TextAnalysisTokenizer.h
+bool splitAtWordBoundaries(const std::string &fileName, unsigned parts, std::vector<std::uint64_t> &boundaries)
+{
+    int fd = open(fileName.c_str(), O_RDONLY);
+    if (fd < 0)
+    {
+        return false;
+    }
+    struct stat info;
+    if (fstat(fd, &info) != 0 || !S_ISREG(info.st_mode))
+    {
+        close(fd);
+        return false; // Only regular files have a size to split
+    }
+
+    std::uint64_t fileSize = static_cast<std::uint64_t>(info.st_size);
+    boundaries.assign(1, 0);
+    char buffer[4096];
+    for (unsigned part = 1; part < parts; part++)
+    {
+        // Move the nominal split point forward to the next separator so that no word is cut in two
+        std::uint64_t position = fileSize / parts * part;
+        if (position <= boundaries.back())
+        {
+            continue;
+        }
+        bool found = false;
+        while (!found && position < fileSize)
+        {
+            ssize_t bytesRead = pread(fd, buffer, sizeof(buffer), static_cast<off_t>(position));
+            if (bytesRead <= 0)
+            {
+                close(fd);
+                return false;
+            }
+            for (ssize_t i = 0; i < bytesRead && !found; i++, position++)
+            {
+                found = !isWordCharacter(buffer[i]);
+            }
+        }
+        if (!found)
+        {
+            break; // The rest of the file is a single word
+        }
+        boundaries.push_back(position - 1);
+    }
+    if (boundaries.back() != fileSize)
+    {
+        boundaries.push_back(fileSize);
+    }
+    close(fd);
+    return true;
+}
+
+/**
+ * Processes each character of the input text, building words to hand to the sink that counts them.
+ * Handles alphanumeric characters and hyphens, and ignores other punctuation, treating words case-insensitively.
+ * Also handles special cases where a word ends with an apostrophe followed by 's', removing the trailing 's.
+ *
+ * @param currentChar The current character being processed from the text.
+ * @param currentWord The current word being built from consecutive characters.
+ * @param wordSink The receiver of every completed word, which inserts it into the counting engine.
+ * @param isWord A flag indicating whether the current sequence of characters constitutes a word.
+ */
+static void processCharacterAndWord(char currentChar, std::string &currentWord, TokenSink &wordSink, bool &isWord)
+{
+    if (std::isalnum(currentChar) || currentChar == '-')
+    {
+        currentWord += std::tolower(currentChar);
+        isWord = true;
+    }
+    else if (isWord)
+    {
+        // Check for trailing 's in words and remove it
+        if (currentWord.length() > 2 && currentWord.substr(currentWord.length() - 2) == "'s")
+        {
+            currentWord = currentWord.substr(0, currentWord.length() - 2);
+        }
+        wordSink.consumeToken(currentWord); // Insert the current word into the BST
+        currentWord = "";                   // Reset currentWord for the next word
+        isWord = false;                     // Reset isWord flag as we've finished processing a word
+    }
+}
+
+// Documented in TextAnalysisTokenizer.h
+void splitAndProcessWords(const std::string &text, TokenSink &wordSink)
+{
+    std::string currentWord;
+    bool isWord = false;
+    for (char c : text)
+    {
+        processCharacterAndWord(c, currentWord, wordSink, isWord);
+    }
+    // Process the last word if the line ends with a word character
+    if (isWord)
+    {
+        wordSink.consumeToken(currentWord);
+    }
+}
+
+// Documented in TextAnalysisTokenizer.h
+bool tokenizeFileByLines(const std::string &fileName, TokenSink &sink)
+{
+    std::ifstream file(fileName); // Open the current file to process
+    if (!file.is_open())
+    {
+        return false;
+    }
+    std::string line; // Holds the current line being processed
+    // Read and process each line in the file
+    while (std::getline(file, line))
+    {
+        splitAndProcessWords(line, sink); // Extract words and hand them to the sink
+    }
+    return true;
+}
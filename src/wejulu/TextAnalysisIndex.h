@@ -0,0 +1,113 @@
+// TextAnalysisIndex.h
+#ifndef TEXTANALYSISINDEX_H
+#define TEXTANALYSISINDEX_H
+
+#include "TextAnalysisCounter.h"
+#include "TextAnalysisReport.h"
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Version of the index file layout, bumped whenever the header or the entry layout changes
+constexpr std::uint32_t indexFormatVersion = 1;
+
+struct IndexHeader;
+struct IndexEntry;
+
+/**
+ * Identity of the analysis an index was saved for. An index is only reused when every field matches, along with
+ * the index format and tokenization rules versions.
+ */
+struct IndexKey
+{
+    std::string sourcePath;          // The analyzed file, as named in input.txt
+    std::uint64_t sourceSize = 0;    // Size of the file in bytes when it was analyzed
+    std::int64_t sourceModified = 0; // Modification time of the file, in nanoseconds since the epoch
+    std::uint32_t configuration = 0; // Caller-defined summary of the options that shape the report
+};
+
+/**
+ * Fills in the size and modification time of a file for an index key.
+ *
+ * @param fileName The file to examine.
+ * @param key The key receiving the path, size and modification time; the configuration is left unchanged.
+ * @return true if the file is a regular file whose attributes could be read, false otherwise.
+ */
+bool describeIndexSource(const std::string &fileName, IndexKey &key);
+
+/**
+ * Returns the path of the index for a key within a cache directory. The name combines a hash of the file's path
+ * with the configuration, so runs with different options keep separate indexes; the index also records the path
+ * itself, so a hash collision only costs a cache miss.
+ *
+ * @param cacheDirectory The directory holding the indexes.
+ * @param key The key of the index; only the path and configuration are used.
+ */
+std::string indexPathFor(const std::string &cacheDirectory, const IndexKey &key);
+
+/**
+ * A saved report of one file: a fixed header holding the key and the probe statistics, the report lines as a
+ * sorted array of (word offset, word length, frequency, position) records, and a blob with the characters of
+ * the source path and every word. All fields use the native byte order; an index written on a machine with a
+ * different byte order fails the version check and is simply rebuilt.
+ *
+ * An open index is memory-mapped and used in place, without parsing.
+ */
+class WordIndex
+{
+public:
+    WordIndex();  // Constructor to initialize an index with nothing mapped
+    ~WordIndex(); // Destructor unmapping the index file
+
+    /**
+     * Maps an index file and checks that it is intact and was saved for the given key with the current format
+     * and tokenization rules.
+     * @param indexPath The index file.
+     * @param key The key the index must match.
+     * @return true if the index can be used, false if it is missing, damaged or stale.
+     */
+    bool open(const std::string &indexPath, const IndexKey &key);
+
+    /**
+     * Appends the saved report (probe statistics, then words with their frequencies and positions, then the
+     * separator line) to a buffer, exactly as the engine that produced it would.
+     * @param out The buffer receiving the report.
+     * @param weighted Whether to include the "Weighted average number of probes" line.
+     */
+    void writeReport(ReportBuffer &out, bool weighted) const;
+
+    /**
+     * Returns the number of distinct words in the open index.
+     */
+    std::size_t size() const;
+
+    /**
+     * Saves a report as an index file. The file is written under a temporary name and renamed into place, so
+     * readers never see a partial index.
+     * @param indexPath The index file to create or replace.
+     * @param key The key the index is saved for.
+     * @param entries The report lines in alphabetical order.
+     * @param statistics The probe statistics of the report.
+     * @return true on success, false if the file could not be written.
+     */
+    static bool save(const std::string &indexPath, const IndexKey &key, const std::vector<ReportEntry> &entries,
+                     const ProbeStatistics &statistics);
+
+private:
+    void *mapping;             // Start of the mapped file, or nullptr
+    std::size_t mappingSize;   // Length of the mapping
+    const IndexHeader *header; // The header at the start of the mapping
+    const IndexEntry *entries; // The report lines following the header
+    const char *blob;          // The characters of the source path and the words
+
+    WordIndex(const WordIndex &) = delete;            // The index owns its mapping, copying is not supported
+    WordIndex &operator=(const WordIndex &) = delete; // The index owns its mapping, copying is not supported
+
+    /**
+     * Unmaps the index file, if any.
+     */
+    void close();
+};
+
+#endif // TEXTANALYSISINDEX_H
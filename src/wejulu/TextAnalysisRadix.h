@@ -0,0 +1,175 @@
+// TextAnalysisRadix.h
+#ifndef TEXTANALYSISRADIX_H
+#define TEXTANALYSISRADIX_H
+
+#include "TextAnalysisArena.h"
+#include "TextAnalysisCounter.h"
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+/**
+ * Word counting engine built on a compressed radix (Patricia) trie. Words sharing a prefix share the nodes that
+ * spell it, and every chain of single-child nodes is collapsed into one node holding the whole run of bytes as its
+ * label, so each distinct word costs roughly one small node plus the bytes in which it differs from its neighbours.
+ *
+ * Nodes are variable-length records of 32-bit words in a pool of large chunks and refer to each other through
+ * 32-bit references instead of pointers. A node's children are kept in an array sized adaptively to 1, 2, 4, ...
+ * 256 entries (like the node sizes of an adaptive radix tree): a node grows into the next size when it runs out of
+ * room, and the record it leaves behind is recycled for later nodes of that size. A reference holds a 12-bit chunk
+ * index and a 20-bit offset, so the pool is limited to 4096 chunks of at most 2^20 words (16 GiB of records);
+ * an insertion that would need more throws std::length_error instead of corrupting the trie.
+ *
+ * Words are stored lowercased, so they are reported in lowercase; the tokenizers already fold every word, so the
+ * reports match the other engines. Children are ordered by byte, which makes a depth-first walk produce the words
+ * in alphabetical order without sorting.
+ *
+ * Probe statistics describe node visits: the number of probes for a word is the number of nodes a lookup visits,
+ * from the root down to the node where the word ends. The position reported after each word's frequency is the
+ * depth of that node (root = 0), matching the BST convention where a word at level L takes L + 1 probes.
+ */
+class RadixWordCounter : public WordCounter
+{
+public:
+    RadixWordCounter();           // Constructor to initialize an empty trie
+    ~RadixWordCounter() override; // Destructor releasing the node pool
+
+    /**
+     * Counts one occurrence of a word, adding it to the trie if it is new.
+     * @param word The word, compared case-insensitively.
+     * @throws std::length_error If the node pool is full (see the reference limit above).
+     */
+    void insert(std::string_view word) override;
+
+    /**
+     * Computes the maximum and average number of node visits needed to find each word.
+     * @param maxProbes A reference to an integer that will store the maximum number of probes encountered.
+     * @param averageProbes A reference to a float that will store the average number of probes encountered.
+     */
+    void computeProbes(int &maxProbes, float &averageProbes) override;
+
+    /**
+     * Computes the average number of node visits weighted by each word's frequency.
+     * @return The weighted average, or 0 for an empty trie.
+     */
+    float computeWeightedProbes() override;
+
+    /**
+     * Appends every word with its frequency, in alphabetical order. The trie does not store words contiguously, so
+     * the collected words are copied into storage owned by the trie. That storage is reused by every collection:
+     * the words stay valid until the next call to collectInOrder or collectReport, or until the trie is destroyed.
+     * @param out The vector receiving the words.
+     */
+    void collectInOrder(std::vector<WordCount> &out) const override;
+
+    /**
+     * Collects the report lines (words with their frequencies and node depths, alphabetically) and the probe
+     * statistics. The words are copied like in collectInOrder, and stay valid until the next collection.
+     * @param entries The vector receiving the report lines.
+     * @param statistics Receives the probe statistics.
+     */
+    void collectReport(std::vector<ReportEntry> &entries, ProbeStatistics &statistics) override;
+
+    /**
+     * Visits the report lines (words with their frequencies and node depths, alphabetically) straight from the
+     * trie walk, without copying the words.
+     * @param visit Called with each word (valid only during the call), its frequency and its node's depth.
+     */
+    void visitReportLines(const ReportLineVisitor &visit) override;
+
+    /**
+     * Fills an empty trie from distinct words with their frequencies.
+     * @param sortedWords The words to add; the words are copied.
+     */
+    void buildFromSorted(const std::vector<WordCount> &sortedWords) override;
+
+    /**
+     * Returns the number of distinct words in the trie.
+     */
+    std::size_t distinctWords() const override;
+
+    /**
+     * Returns the usage of the node pool, for memory reporting. Allocations count node records, blocks count pool
+     * chunks; the words copied out by collectInOrder and collectReport are not included.
+     */
+    ArenaStats getArenaStats() const override;
+
+private:
+    std::vector<std::unique_ptr<std::uint32_t[]>> chunks; // Pool chunks; records never move once allocated
+    std::uint32_t chunkUsed;                              // Words used in the last chunk
+    std::uint32_t chunkSize;                              // Words in the last chunk
+    std::vector<std::vector<std::uint32_t>> freeRecords;  // Recycled records, indexed by their size in words
+    std::uint32_t root;                                   // Reference to the root node, which has an empty label
+    std::size_t wordCount;                                // Number of distinct words
+    ArenaStats poolStats;                                 // Usage of the node pool
+    mutable NodeArena copies;                             // Words copied out by the last collection
+
+    RadixWordCounter(const RadixWordCounter &) = delete;            // The trie owns its pool, copying is not supported
+    RadixWordCounter &operator=(const RadixWordCounter &) = delete; // The trie owns its pool, copying is not supported
+
+    /**
+     * Adds occurrences of a word, inserting it if it is new.
+     * @param word The word to count.
+     * @param frequency The number of occurrences to add.
+     */
+    void add(std::string_view word, int frequency);
+
+    /**
+     * Returns the record a reference points to. Records stay in place until they are released.
+     * @param reference The reference to resolve.
+     */
+    std::uint32_t *record(std::uint32_t reference) const;
+
+    /**
+     * Allocates a node record with no children and a zero frequency.
+     * @param labelLength The length of the node's label in bytes.
+     * @param sizeClass The capacity class of the child array (0 = no children, c = 2^(c-1) children).
+     * @return The reference to the new record.
+     * @throws std::length_error If a new chunk is needed and the pool already holds the most references can select.
+     */
+    std::uint32_t allocateNode(std::size_t labelLength, unsigned sizeClass);
+
+    /**
+     * Returns a record to the pool for reuse by a later node of the same size.
+     * @param reference The record to release.
+     */
+    void releaseNode(std::uint32_t reference);
+
+    /**
+     * Copies a node into a new record, dropping the first bytes of its label and/or changing its capacity class,
+     * then releases the original.
+     * @param reference The node to copy.
+     * @param labelStart The number of label bytes to drop from the front.
+     * @param sizeClass The capacity class of the copy, large enough for the node's children.
+     * @return The reference to the copy.
+     */
+    std::uint32_t rebuildNode(std::uint32_t reference, std::size_t labelStart, unsigned sizeClass);
+
+    /**
+     * Creates the node (or chain of nodes, for very long labels) holding the end of a word.
+     * @param word The word.
+     * @param start The first byte of the word not yet spelled by the nodes above.
+     * @param frequency The word's frequency.
+     * @return The reference to the first node created.
+     */
+    std::uint32_t createLeaf(std::string_view word, std::size_t start, int frequency);
+
+    /**
+     * Adds a child to a node, growing the node into a larger record if its child array is full.
+     * @param link The location holding the node's reference, updated if the node moves.
+     * @param key The first byte of the child's part of the words.
+     * @param child The reference to the child.
+     */
+    void addChild(std::uint32_t *link, unsigned char key, std::uint32_t child);
+
+    /**
+     * Visits every word in alphabetical order without recursion.
+     * @param visit Called with the word (valid only during the call), its frequency and its node's depth.
+     */
+    template <typename Visitor>
+    void visitInOrder(Visitor visit) const;
+};
+
+#endif // TEXTANALYSISRADIX_H
@@ -0,0 +1,123 @@
+// TextAnalysisReport.h
+#ifndef TEXTANALYSISREPORT_H
+#define TEXTANALYSISREPORT_H
+
+#include <cstddef>
+#include <string>
+#include <string_view>
+
+/**
+ * In-memory text buffer with locale-independent number formatting, used to render report blocks.
+ * The formatters produce exactly what the standard streams print in the default "C" locale, without going
+ * through ostream formatting state.
+ */
+class ReportBuffer
+{
+public:
+    /**
+     * Appends text to the buffer.
+     * @param text The text to append.
+     */
+    void append(std::string_view text) { data.append(text.data(), text.size()); }
+
+    /**
+     * Appends a single character to the buffer.
+     * @param c The character to append.
+     */
+    void append(char c) { data += c; }
+
+    /**
+     * Appends an integer in decimal, as `out << value` would.
+     * @param value The integer to append.
+     */
+    void appendInteger(long long value);
+
+    /**
+     * Appends a number with exactly one decimal, as `out << std::fixed << std::setprecision(1) << value` would
+     * (including its round-half-to-even behaviour on exact ties).
+     * @param value The number to append.
+     */
+    void appendFixed1(float value);
+
+    /**
+     * Returns the buffered text.
+     */
+    std::string_view view() const { return data; }
+
+    /**
+     * Returns the number of buffered bytes.
+     */
+    std::size_t size() const { return data.size(); }
+
+    /**
+     * Empties the buffer, keeping its capacity for reuse.
+     */
+    void clear() { data.clear(); }
+
+protected:
+    std::string data; // The buffered text
+};
+
+/**
+ * Report sink that keeps a single file descriptor open for the whole run. Text is collected in a large buffer
+ * and written out in big chunks, so a run over thousands of files costs a handful of write calls instead of an
+ * open, a close and several flushes per file.
+ */
+class ReportWriter : public ReportBuffer
+{
+public:
+    ReportWriter();  // Constructor to initialize a writer without an open file
+    ~ReportWriter(); // Destructor flushing the remaining text and closing the file
+
+    /**
+     * Opens the output file.
+     * @param fileName The path of the file.
+     * @param append true to append to an existing file, false to truncate it.
+     * @return true if the file could be opened, false otherwise.
+     */
+    bool open(const std::string &fileName, bool append);
+
+    /**
+     * Writes the buffered text once it has grown past the flush threshold; cheap to call after every block.
+     * @return false if a write failed, true otherwise.
+     */
+    bool flushIfFull() { return data.size() < flushThreshold || flush(); }
+
+    /**
+     * Writes out all buffered text.
+     * @return false if a write failed (now or earlier), true otherwise.
+     */
+    bool flush();
+
+    /**
+     * Appends a block rendered elsewhere (for example by a worker thread). Large blocks are written together with
+     * the pending buffer in one writev call instead of being copied into it.
+     * @param block The text to write.
+     * @return false if a write failed, true otherwise.
+     */
+    bool writeBlock(std::string_view block);
+
+    /**
+     * Flushes the remaining text and closes the file.
+     * @return false if any write failed, true otherwise.
+     */
+    bool close();
+
+private:
+    static const std::size_t flushThreshold = 1024 * 1024; // Buffered bytes that trigger a write
+
+    int fd;      // The output file, or -1 when closed
+    bool failed; // Set once a write has failed
+
+    ReportWriter(const ReportWriter &) = delete;            // Owns the file descriptor, copying is not supported
+    ReportWriter &operator=(const ReportWriter &) = delete; // Owns the file descriptor, copying is not supported
+
+    /**
+     * Writes the pending buffer followed by an extra block with as few system calls as possible.
+     * @param extra The block written after the buffer, may be empty.
+     * @return false if a write failed, true otherwise.
+     */
+    bool writeOut(std::string_view extra);
+};
+
+#endif // TEXTANALYSISREPORT_H
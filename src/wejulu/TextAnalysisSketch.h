@@ -0,0 +1,182 @@
+// TextAnalysisSketch.h
+#ifndef TEXTANALYSISSKETCH_H
+#define TEXTANALYSISSKETCH_H
+
+#include "TextAnalysisReport.h"
+#include "TextAnalysisTokenizer.h"
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Longest word the top-K tracker can hold; longer words are still counted by the sketch but never ranked
+static const std::size_t streamWordLength = 40;
+
+// Number of rows of the Count-Min sketch; every row lowers the chance of an overestimate beyond the bound
+static const std::size_t sketchDepth = 4;
+
+/**
+ * Count-Min sketch: a fixed grid of counters, sketchDepth rows by a power-of-two number of columns. Every word
+ * is hashed to one counter per row; its estimate is the smallest of those counters. Collisions can only add to a
+ * counter, so an estimate is never below the true count, and with W columns it exceeds the true count by more
+ * than e/W times the number of words counted with probability at most e^-sketchDepth.
+ *
+ * Counters are raised with the conservative update (only the counters holding the current minimum are
+ * incremented), which keeps the same guarantees and usually tightens the estimates.
+ */
+class CountMinSketch
+{
+public:
+    /**
+     * Constructor to initialize an empty sketch using at most the given memory.
+     * @param bytes The memory budget of the counters; the width is the largest power of two that fits.
+     */
+    explicit CountMinSketch(std::size_t bytes);
+
+    /**
+     * Counts one occurrence of a word.
+     * @param hash The 64-bit hash of the word.
+     * @return The word's estimated count, including this occurrence.
+     */
+    std::uint64_t add(std::uint64_t hash);
+
+    /**
+     * Returns a word's estimated count, never below its true count.
+     * @param hash The 64-bit hash of the word.
+     */
+    std::uint64_t estimate(std::uint64_t hash) const;
+
+    /**
+     * Returns the number of columns of the sketch.
+     */
+    std::size_t width() const { return mask + 1; }
+
+private:
+    std::vector<std::uint64_t> cells; // sketchDepth rows of width() counters, row after row
+    std::size_t mask;                 // width() - 1, for reducing hashes to a column
+};
+
+/**
+ * One word monitored by the Space-Saving tracker. The word was taken over from a monitored word with
+ * `error` occurrences, so its true count lies between count - error and count.
+ */
+struct StreamCounter
+{
+    std::uint64_t hash;          // Hash of the word
+    std::int64_t count;          // Occurrences attributed to the word, never below its true count
+    std::int64_t error;          // Occurrences inherited when the word took over the counter
+    std::uint32_t length;        // Length of the word in bytes
+    std::uint32_t heapPosition;  // Position of the counter in the min-heap
+    char word[streamWordLength]; // The word itself
+};
+
+/**
+ * Bounded-memory counter of an unbounded stream of words. Every word goes into a Count-Min sketch, and a
+ * Space-Saving tracker monitors a fixed number of candidate heavy hitters: a monitored word's counter is
+ * incremented, and an unmonitored word takes over the counter with the smallest count, inheriting that count as
+ * its error. Any word occurring more often than (words / monitored counters) is always monitored.
+ *
+ * Both structures overestimate and never underestimate, so a monitored word's true count is at most the smaller
+ * of its counter and its sketch estimate, and at least its counter minus its error. Memory is fixed when the
+ * tracker is created, regardless of the length of the stream or the number of distinct words.
+ */
+class StreamingTopK : public TokenSink
+{
+public:
+    /**
+     * Constructor to initialize an empty tracker.
+     * @param memoryBudget The bytes shared by the sketch (half) and the monitored counters (the other half).
+     * @param topCount The number of words listed by each snapshot.
+     */
+    StreamingTopK(std::size_t memoryBudget, std::size_t topCount);
+
+    /**
+     * Counts one word of the stream.
+     * @param word The lowercased word.
+     */
+    void consumeToken(std::string_view word) override;
+
+    /**
+     * Appends a snapshot of the current top words to a buffer: the source name, the number of words counted, the
+     * largest possible overestimate of any listed count, then one `word count (overestimate)` line per word, most
+     * frequent first, then the separator line. The number in parentheses bounds how far that word's count may
+     * exceed its true count.
+     * @param out The buffer receiving the snapshot.
+     * @param source The name of the stream, printed on the first line.
+     */
+    void writeSnapshot(ReportBuffer &out, std::string_view source) const;
+
+    /**
+     * Returns the number of words counted so far.
+     */
+    std::uint64_t wordsCounted() const { return words; }
+
+    /**
+     * Returns the number of words that can be monitored at once.
+     */
+    std::size_t capacity() const { return counters.size(); }
+
+    /**
+     * Returns the number of columns of the sketch.
+     */
+    std::size_t sketchWidth() const { return sketch.width(); }
+
+    /**
+     * Returns the bounds of a word's true count: false if the word is not monitored, otherwise true with
+     * lower <= true count <= upper.
+     * @param word The lowercased word.
+     * @param lower Receives the lower bound.
+     * @param upper Receives the upper bound, the reported count.
+     */
+    bool bounds(std::string_view word, std::int64_t &lower, std::int64_t &upper) const;
+
+private:
+    CountMinSketch sketch;               // Estimates of every word, including unmonitored ones
+    std::vector<StreamCounter> counters; // Monitored words; only the first `used` are in use
+    std::vector<std::uint32_t> heap;     // Counter indices, a min-heap on count
+    std::vector<std::uint32_t> table;    // Open-addressing index from word to counter, noCounter when empty
+    std::size_t used;                    // Number of counters in use
+    std::size_t topCount;                // Number of words listed by each snapshot
+    std::uint64_t words;                 // Words counted so far
+
+    /**
+     * Returns the table slot holding a word's counter, or the empty slot where it would go.
+     * @param word The word.
+     * @param hash The word's hash.
+     */
+    std::size_t findSlot(std::string_view word, std::uint64_t hash) const;
+
+    /**
+     * Removes a counter from the table, moving later entries of its probe run back so lookups still find them.
+     * @param slot The slot holding the counter.
+     */
+    void eraseSlot(std::size_t slot);
+
+    /**
+     * Restores the heap order after a counter's count has grown.
+     * @param position The counter's position in the heap.
+     */
+    void siftDown(std::size_t position);
+
+    /**
+     * Restores the heap order after a counter has been added with a count smaller than its ancestors'.
+     * @param position The counter's position in the heap.
+     */
+    void siftUp(std::size_t position);
+
+    /**
+     * Returns the upper bound of a monitored word's true count.
+     * @param counter The word's counter.
+     */
+    std::int64_t upperBound(const StreamCounter &counter) const;
+};
+
+/**
+ * Hashes a lowercased word for the streaming structures.
+ * @param word The word.
+ * @return Its 64-bit hash.
+ */
+std::uint64_t hashStreamWord(std::string_view word);
+
+#endif // TEXTANALYSISSKETCH_H
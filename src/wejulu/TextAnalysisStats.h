@@ -0,0 +1,74 @@
+// TextAnalysisStats.h
+#ifndef TEXTANALYSISSTATS_H
+#define TEXTANALYSISSTATS_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Whether the pipeline counters are compiled in (see TEXTANALYSIS_INSTRUMENTATION in CMakeLists.txt)
+#ifndef TEXTANALYSIS_STATS
+#define TEXTANALYSIS_STATS 0
+#endif
+
+// Keeps a statement only in instrumented builds, so that counting costs nothing when instrumentation is disabled
+#if TEXTANALYSIS_STATS
+#define TEXTANALYSIS_STAT(statement) statement
+#else
+#define TEXTANALYSIS_STAT(statement)
+#endif
+
+// Work done by an engine while counting words, gathered in instrumented builds
+struct InsertStats
+{
+    std::uint64_t comparisons = 0;     // Word comparisons performed by insertions
+    std::uint64_t nodeAllocations = 0; // Nodes allocated for the counted words
+    int peakDepth = 0;                 // Deepest level an insertion reached (root = 0)
+};
+
+// Wall time spent in each phase of analyzing a file, in seconds
+struct PhaseTimes
+{
+    double ingest = 0;   // Reading, tokenizing and inserting the words (or counting the parts, with --split)
+    double insert = 0;   // Part of ingest spent inserting, timed around every batch of insertions
+    double merge = 0;    // Merging the parts counted by --split
+    double optimize = 0; // Rebuilding the tree for --optimize
+    double report = 0;   // Rendering the report block
+    double cache = 0;    // Looking up the cached index and saving a new one
+    double total = 0;    // The whole file, from the cache lookup to the saved index
+};
+
+// Telemetry of one analyzed file, or of the whole run, for the --stats sidecar
+struct FileStats
+{
+    std::string fileName;              // The analyzed file (empty for the aggregate)
+    std::string outcome;               // "counted", "cached" or "failed"
+    PhaseTimes seconds;                // Time per phase
+    std::uint64_t bytesRead = 0;       // Bytes of input read
+    std::uint64_t tokens = 0;          // Words read, repeated ones included
+    std::uint64_t distinctWords = 0;   // Distinct words counted
+    bool engineCounters = false;       // Whether the engine reported the counters below
+    InsertStats engine;                // Comparisons, node allocations and peak depth of the engine
+
+    /**
+     * Adds another file's telemetry to this one: sums, except for the peak depth which is the maximum.
+     * @param other The telemetry to add.
+     */
+    void add(const FileStats &other);
+};
+
+/**
+ * Writes the --stats sidecar: one record per file followed by the aggregate of the whole run. The format follows
+ * the file name: CSV (one header line, one row per file, then a TOTAL row) for names ending in ".csv", JSON
+ * otherwise.
+ *
+ * @param fileName The path of the sidecar.
+ * @param files The telemetry of every file, in input order.
+ * @param aggregate The telemetry of the whole run.
+ * @param wallSeconds The wall time of the whole run, in seconds.
+ * @return true if the sidecar was written, false otherwise.
+ */
+bool writeStatsSidecar(const std::string &fileName, const std::vector<FileStats> &files, const FileStats &aggregate,
+                       double wallSeconds);
+
+#endif // TEXTANALYSISSTATS_H
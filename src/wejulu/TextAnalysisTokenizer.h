@@ -0,0 +1,167 @@
+// TextAnalysisTokenizer.h
+#ifndef TEXTANALYSISTOKENIZER_H
+#define TEXTANALYSISTOKENIZER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Version of the tokenization rules below (and of the line-based splitAndProcessWords). Cached word
+// indexes record it and are discarded when it differs, so it must be bumped whenever the rules change.
+constexpr std::uint32_t tokenizerRulesVersion = 1;
+
+/**
+ * Implementation used to classify input bytes into word and separator characters.
+ * The vectorized kernels examine 16 (SSE2) or 32 (AVX2) bytes per instruction; all kernels produce identical words.
+ */
+enum class TokenizerKernel
+{
+    Auto,   // Fastest kernel supported by the running CPU
+    Scalar, // Table lookup per byte, available everywhere
+    SSE2,   // 16 bytes at a time, the x86-64 baseline
+    AVX2    // 32 bytes at a time, selected at runtime when the CPU supports it
+};
+
+/**
+ * Chooses the classification kernel used by every Tokenizer in the process. Must be called before tokenizing
+ * starts on any thread.
+ *
+ * @param kernel The kernel to use; Auto picks the fastest one the CPU supports.
+ * @return true if the kernel is available in this build and on this CPU, false otherwise (the selection is unchanged).
+ */
+bool selectTokenizerKernel(TokenizerKernel kernel);
+
+/**
+ * Returns the kernel currently used by the tokenizer (never Auto).
+ */
+TokenizerKernel activeTokenizerKernel();
+
+/**
+ * Returns a printable name for a kernel, as accepted by the --kernel option.
+ * @param kernel The kernel to name.
+ */
+const char *tokenizerKernelName(TokenizerKernel kernel);
+
+/**
+ * Receiver for the words produced by a Tokenizer.
+ */
+class TokenSink
+{
+public:
+    virtual ~TokenSink() {}
+
+    /**
+     * Called once per word, in input order. The word is already lowercased; the view is only valid for the
+     * duration of the call, so implementations must copy it if they keep it.
+     * @param word The word that was found.
+     */
+    virtual void consumeToken(std::string_view word) = 0;
+};
+
+/**
+ * Incremental word splitter applying the same rules as the line-based splitAndProcessWords: a word is a run of
+ * ASCII letters, digits and hyphens, it is folded to lowercase, and a trailing 's is stripped. Anything else,
+ * including apostrophes and bytes outside ASCII, separates words.
+ *
+ * Input may arrive in arbitrary chunks (for example successive windows of a memory-mapped file). Words lying
+ * inside a chunk are handed to the sink as views into the caller's buffer without copying; only words that are
+ * split across chunks or that contain uppercase letters are assembled in an internal buffer.
+ */
+class Tokenizer
+{
+public:
+    /**
+     * Constructor to initialize a tokenizer.
+     * @param sink The receiver of every word found.
+     */
+    explicit Tokenizer(TokenSink &sink);
+
+    /**
+     * Splits the next chunk of input into words.
+     * @param data The chunk, which only needs to stay valid for the duration of the call.
+     * @param length The number of bytes in the chunk.
+     */
+    void feed(const char *data, std::size_t length);
+
+    /**
+     * Emits the word still pending at the end of the input, if any.
+     */
+    void finish();
+
+private:
+    TokenSink &sink;     // Receiver of the words
+    std::string pending; // Lowercased prefix of a word that continues into the next chunk
+    std::string folded;  // Scratch buffer for lowercasing words that contain uppercase letters
+
+    /**
+     * Finds the words of a chunk from its classification bitmasks and hands them to the sink.
+     * A word still running at the end of the chunk is moved to the pending buffer.
+     * @param data The chunk.
+     * @param position The offset at which scanning starts, always outside a word.
+     * @param length The number of bytes in the chunk.
+     */
+    void scan(const char *data, std::size_t position, std::size_t length);
+
+    /**
+     * Hands a complete word to the sink, lowercasing it and stripping a trailing 's first.
+     * @param word The word exactly as it appears in the input.
+     * @param hasUpper Whether the word contains uppercase letters that must be folded.
+     */
+    void emit(std::string_view word, bool hasUpper);
+};
+
+/**
+ * Tokenizes a whole file, mapping it into memory one window at a time so that files larger than the available
+ * RAM can be processed. Falls back to buffered reads for inputs that cannot be mapped, such as pipes.
+ *
+ * @param fileName The path of the file to read.
+ * @param sink The receiver of every word found.
+ * @return true on success, false if the file could not be opened or read.
+ */
+bool tokenizeFile(const std::string &fileName, TokenSink &sink);
+
+/**
+ * Tokenizes a byte range of a regular file in the same way as tokenizeFile. The range is treated as a complete
+ * input, so its ends must fall on separators (see splitAtWordBoundaries) for the words to match a whole-file run.
+ *
+ * @param fileName The path of the file to read.
+ * @param begin The offset of the first byte of the range.
+ * @param end The offset one past the last byte of the range.
+ * @param sink The receiver of every word found.
+ * @return true on success, false if the file could not be opened or read.
+ */
+bool tokenizeFileRange(const std::string &fileName, std::uint64_t begin, std::uint64_t end, TokenSink &sink);
+
+/**
+ * Divides a regular file into at most the requested number of byte ranges of roughly equal size, moving every
+ * split point forward to the next separator so that no word straddles two ranges. Fewer ranges are produced
+ * when the file is too small or a single word covers several split points.
+ *
+ * @param fileName The path of the file to split.
+ * @param parts The desired number of ranges.
+ * @param boundaries Receives the offsets 0 = b0 < b1 < ... < bk = file size; range i is [b(i), b(i+1)).
+ * @return true on success, false if the file could not be opened, is not a regular file, or could not be read.
+ */
+bool splitAtWordBoundaries(const std::string &fileName, unsigned parts, std::vector<std::uint64_t> &boundaries);
+
+/**
+ * Processes a line of text character by character, handing every word to the sink. This is the original reader
+ * the Tokenizer reproduces; it stays the reference for its rules and the implementation of '--ingest getline'.
+ *
+ * @param text The line of text to be processed.
+ * @param wordSink The receiver of the extracted words.
+ */
+void splitAndProcessWords(const std::string &text, TokenSink &wordSink);
+
+/**
+ * Tokenizes a whole file one line at a time with splitAndProcessWords.
+ *
+ * @param fileName The path of the file to read.
+ * @param sink The receiver of every word found.
+ * @return true on success, false if the file could not be opened.
+ */
+bool tokenizeFileByLines(const std::string &fileName, TokenSink &sink);
+
+#endif // TEXTANALYSISTOKENIZER_H
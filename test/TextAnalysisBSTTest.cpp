@@ -0,0 +1,110 @@
+// TextAnalysisBSTTest.cpp
+//
+// Regression test for the iterative WordBST: five million strictly increasing words are inserted in unbalanced and
+// AVL mode, then probed, reported and collected on a thread whose stack is far too small for any recursion over the
+// tree, so that a recursive insertion or traversal coming back makes the test crash.
+
+#include "TextAnalysisBST.h"
+#include "TextAnalysisTest.h"
+#include <cmath>
+#include <cstdio>
+#include <pthread.h>
+#include <string>
+#include <vector>
+
+// Words inserted per balance mode
+static const int wordCount = 5000000;
+
+// Stack of the thread running the test; a recursive walk down a chain of wordCount nodes needs far more
+static const std::size_t testStackSize = 64 * 1024;
+
+// Returns the i-th word of the increasing sequence ("w0000000", "w0000001", ...)
+static std::string increasingWord(int i)
+{
+    char word[16];
+    std::snprintf(word, sizeof(word), "w%07d", i);
+    return word;
+}
+
+/**
+ * Inserts the increasing words in one balance mode and checks the probe statistics, the report and the collected
+ * report lines.
+ * @param mode The balance mode.
+ * @param name The name of the mode, for messages.
+ */
+static void checkIncreasingWords(BalanceMode mode, const char *name)
+{
+    WordBST tree(mode);
+    for (int i = 0; i < wordCount; i++)
+    {
+        tree.insert(increasingWord(i));
+    }
+    tree.insert(increasingWord(0)); // One repeated word, found at the far end of the unbalanced chain
+    TEXTANALYSIS_CHECK(tree.distinctWords() == static_cast<std::size_t>(wordCount));
+
+    int maxProbes = 0;
+    float averageProbes = 0;
+    tree.computeProbes(maxProbes, averageProbes);
+    std::cout << name << ": maximum " << maxProbes << " probes, average " << averageProbes << std::endl;
+    if (mode == BalanceMode::None)
+    {
+        // Every word hangs to the right of the previous one: a chain with one more probe per word
+        TEXTANALYSIS_CHECK(maxProbes == wordCount);
+        TEXTANALYSIS_CHECK(std::fabs(averageProbes - (wordCount + 1) / 2.0) < 1);
+    }
+    else
+    {
+        // An AVL tree of n nodes is at most 1.44 log2(n) high
+        TEXTANALYSIS_CHECK(maxProbes <= 1.44 * std::log2(static_cast<double>(wordCount)));
+        TEXTANALYSIS_CHECK(averageProbes <= maxProbes);
+    }
+
+    std::vector<ReportEntry> entries;
+    ProbeStatistics statistics;
+    tree.collectReport(entries, statistics);
+    TEXTANALYSIS_CHECK(statistics.maxProbes == maxProbes);
+    TEXTANALYSIS_CHECK(statistics.averageProbes == averageProbes);
+    TEXTANALYSIS_CHECK(entries.size() == static_cast<std::size_t>(wordCount));
+    bool inOrder = true;
+    for (std::size_t i = 0; i < entries.size(); i++)
+    {
+        inOrder = inOrder && entries[i].word == increasingWord(static_cast<int>(i)) &&
+                  entries[i].frequency == (i == 0 ? 2 : 1) &&
+                  (mode != BalanceMode::None || entries[i].position == static_cast<int>(i));
+    }
+    TEXTANALYSIS_CHECK(inOrder);
+    std::string expectedStart = "Maximum number of probes: " + std::to_string(maxProbes) + "\n";
+    std::string expectedEnd = increasingWord(wordCount - 1) + " 1 (" + std::to_string(entries.back().position) +
+                              ")\n--------------------\n";
+    std::vector<ReportEntry>().swap(entries); // Release the lines before rendering the report
+
+    ReportBuffer report;
+    tree.writeReport(report);
+    std::string_view text = report.view();
+    TEXTANALYSIS_CHECK(text.substr(0, expectedStart.size()) == expectedStart);
+    TEXTANALYSIS_CHECK(text.size() > expectedEnd.size() && text.substr(text.size() - expectedEnd.size()) == expectedEnd);
+}
+
+// Body of the small-stack thread
+static void *runChecks(void *)
+{
+    checkIncreasingWords(BalanceMode::None, "none");
+    checkIncreasingWords(BalanceMode::AVL, "avl");
+    return nullptr;
+}
+
+int main()
+{
+    pthread_attr_t attributes;
+    pthread_attr_init(&attributes);
+    pthread_attr_setstacksize(&attributes, testStackSize);
+    pthread_t thread;
+    if (pthread_create(&thread, &attributes, runChecks, nullptr) != 0)
+    {
+        std::cerr << "Could not start the test thread" << std::endl;
+        return 1;
+    }
+    pthread_join(thread, nullptr);
+    pthread_attr_destroy(&attributes);
+    return testResult("TextAnalysisBSTTest");
+}
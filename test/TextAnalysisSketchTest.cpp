@@ -0,0 +1,170 @@
+// TextAnalysisSketchTest.cpp
+//
+// Bounds test of the streaming top-K tracker: a seeded Zipf-distributed stream is counted exactly by a
+// HashWordCounter and approximately by StreamingTopK at several memory budgets, and every word of the snapshot must
+// satisfy the documented guarantees: count - overestimate <= true count <= count, every overestimate within the
+// printed maximum, that maximum within words / monitored counters, and every word more frequent than that monitored.
+
+#include "TextAnalysisHash.h"
+#include "TextAnalysisSketch.h"
+#include "TextAnalysisTest.h"
+#include <cmath>
+#include <cstdio>
+#include <random>
+#include <sstream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Distinct words the stream draws from, far more than any tested budget can monitor
+static const int vocabularySize = 100000;
+
+// Words in the stream
+static const int streamLength = 2000000;
+
+// Exponent of the Zipf distribution: the word of rank r occurs in proportion to 1 / r^zipfExponent
+static const double zipfExponent = 1.1;
+
+// Returns the word of a given rank; the names do not follow the ranks alphabetically
+static std::string vocabularyWord(int rank)
+{
+    char word[16];
+    std::snprintf(word, sizeof(word), "z%05x", static_cast<unsigned>(rank) * 40503u % 1048576u);
+    return word;
+}
+
+/**
+ * Generates the stream, seeded so that every run checks the same input.
+ * @return The ranks of the words of the stream, in order.
+ */
+static std::vector<int> zipfStream()
+{
+    std::vector<double> weights(vocabularySize);
+    for (int rank = 0; rank < vocabularySize; rank++)
+    {
+        weights[rank] = 1.0 / std::pow(rank + 1, zipfExponent);
+    }
+    std::mt19937_64 random(20240612);
+    std::discrete_distribution<int> distribution(weights.begin(), weights.end());
+    std::vector<int> stream(streamLength);
+    for (int &rank : stream)
+    {
+        rank = distribution(random);
+    }
+    return stream;
+}
+
+/**
+ * Counts the stream with one memory budget and checks the snapshot against the exact counts.
+ * @param words The words of the vocabulary, by rank.
+ * @param stream The ranks of the words of the stream.
+ * @param exact The true count of every word of the stream.
+ * @param memoryBudget The memory budget of the tracker.
+ */
+static void checkBudget(const std::vector<std::string> &words, const std::vector<int> &stream,
+                        const std::unordered_map<std::string, int> &exact, std::size_t memoryBudget)
+{
+    // Every monitored word is listed, so that the whole tracker is checked
+    StreamingTopK tracker(memoryBudget, vocabularySize);
+    for (int rank : stream)
+    {
+        tracker.consumeToken(words[rank]);
+    }
+    TEXTANALYSIS_CHECK(tracker.wordsCounted() == static_cast<std::uint64_t>(streamLength));
+    TEXTANALYSIS_CHECK(tracker.capacity() < exact.size()); // Counters must have been taken over
+    const std::int64_t errorBound = streamLength / static_cast<std::int64_t>(tracker.capacity());
+    std::cout << memoryBudget << " bytes: " << tracker.capacity() << " monitored words, " << tracker.sketchWidth()
+              << " sketch columns, overestimates bounded by " << errorBound << std::endl;
+
+    ReportBuffer snapshot;
+    tracker.writeSnapshot(snapshot, "zipf");
+    std::istringstream lines{std::string(snapshot.view())};
+    std::string line;
+    long long counted = 0, maximumOverestimate = -1;
+    std::getline(lines, line);
+    TEXTANALYSIS_CHECK(line == "zipf");
+    TEXTANALYSIS_CHECK(std::getline(lines, line) && std::sscanf(line.c_str(), "Words counted: %lld", &counted) == 1);
+    TEXTANALYSIS_CHECK(counted == streamLength);
+    TEXTANALYSIS_CHECK(std::getline(lines, line) &&
+                       std::sscanf(line.c_str(), "Maximum overestimate: %lld", &maximumOverestimate) == 1);
+    TEXTANALYSIS_CHECK(maximumOverestimate >= 0 && maximumOverestimate <= errorBound);
+
+    std::size_t listed = 0;
+    bool withinBounds = true;
+    while (std::getline(lines, line) && line != "--------------------")
+    {
+        char word[64];
+        long long count = 0, overestimate = 0;
+        if (std::sscanf(line.c_str(), "%63s %lld (%lld)", word, &count, &overestimate) != 3)
+        {
+            std::cerr << "Unreadable snapshot line: " << line << std::endl;
+            TEXTANALYSIS_CHECK(false);
+            continue;
+        }
+        listed++;
+        auto found = exact.find(word);
+        long long trueCount = found == exact.end() ? 0 : found->second;
+        std::int64_t lower = 0, upper = 0;
+        bool ok = found != exact.end() && count - overestimate <= trueCount && trueCount <= count &&
+                  overestimate <= maximumOverestimate && tracker.bounds(word, lower, upper) && upper == count &&
+                  lower == count - overestimate;
+        if (!ok && withinBounds)
+        {
+            std::cerr << "Word " << word << ": reported " << count << " (" << overestimate << "), true count "
+                      << trueCount << ", maximum overestimate " << maximumOverestimate << std::endl;
+        }
+        withinBounds = withinBounds && ok;
+    }
+    TEXTANALYSIS_CHECK(withinBounds);
+    TEXTANALYSIS_CHECK(line == "--------------------");
+    TEXTANALYSIS_CHECK(listed == tracker.capacity());
+
+    // Space-Saving guarantee: any word occurring more than words / monitored counters times is monitored
+    int heavyHitters = 0;
+    bool allMonitored = true;
+    for (const auto &[word, trueCount] : exact)
+    {
+        std::int64_t lower = 0, upper = 0;
+        if (trueCount > errorBound)
+        {
+            heavyHitters++;
+            allMonitored = allMonitored && tracker.bounds(word, lower, upper);
+        }
+    }
+    std::cout << memoryBudget << " bytes: " << heavyHitters << " words above the bound, all monitored: "
+              << (allMonitored ? "yes" : "no") << std::endl;
+    TEXTANALYSIS_CHECK(heavyHitters > 0);
+    TEXTANALYSIS_CHECK(allMonitored);
+}
+
+int main()
+{
+    std::vector<std::string> words(vocabularySize);
+    for (int rank = 0; rank < vocabularySize; rank++)
+    {
+        words[rank] = vocabularyWord(rank);
+    }
+    std::vector<int> stream = zipfStream();
+
+    // The exact counts come from the hash engine
+    HashWordCounter counter;
+    for (int rank : stream)
+    {
+        counter.insert(words[rank]);
+    }
+    std::vector<WordCount> counts;
+    counter.collectInOrder(counts);
+    std::unordered_map<std::string, int> exact;
+    for (const WordCount &count : counts)
+    {
+        exact.emplace(std::string(count.word), count.frequency);
+    }
+    TEXTANALYSIS_CHECK(exact.size() <= static_cast<std::size_t>(vocabularySize));
+
+    // Budgets monitoring a few hundred to tens of thousands of words, all far fewer than the distinct words
+    for (std::size_t memoryBudget : {std::size_t(64) * 1024, std::size_t(1024) * 1024, std::size_t(4096) * 1024})
+    {
+        checkBudget(words, stream, exact, memoryBudget);
+    }
+    return testResult("TextAnalysisSketchTest");
+}
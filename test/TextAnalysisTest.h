@@ -0,0 +1,83 @@
+// TextAnalysisTest.h
+#ifndef TEXTANALYSISTEST_H
+#define TEXTANALYSISTEST_H
+
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <unistd.h>
+
+// Number of failed checks so far in this test program
+inline int testFailures = 0;
+
+/**
+ * Reports a failed check and counts it; the test goes on so that one run shows every broken case.
+ * @param condition The text of the condition that did not hold.
+ * @param file The source file of the check.
+ * @param line The line of the check.
+ */
+inline void testFailed(const char *condition, const char *file, int line)
+{
+    std::cerr << file << ':' << line << ": check failed: " << condition << std::endl;
+    testFailures++;
+}
+
+// Checks a condition, reporting it with its location when it does not hold
+#define TEXTANALYSIS_CHECK(condition) ((condition) ? (void)0 : testFailed(#condition, __FILE__, __LINE__))
+
+/**
+ * Prints the outcome of a test program and returns its exit status.
+ * @param name The name of the test program.
+ * @return 0 if every check passed, 1 otherwise.
+ */
+inline int testResult(const char *name)
+{
+    if (testFailures == 0)
+    {
+        std::cout << name << ": all checks passed" << std::endl;
+        return 0;
+    }
+    std::cout << name << ": " << testFailures << " check(s) failed" << std::endl;
+    return 1;
+}
+
+/**
+ * A uniquely named file in the temporary directory ($TMPDIR, or /tmp), removed when the object goes out of scope.
+ */
+class TemporaryFile
+{
+public:
+    /**
+     * Constructor to create an empty temporary file.
+     * @param prefix The start of the file name.
+     */
+    explicit TemporaryFile(const std::string &prefix)
+    {
+        const char *directory = std::getenv("TMPDIR");
+        std::string pattern = std::string(directory != nullptr ? directory : "/tmp") + "/" + prefix + "XXXXXX";
+        int fd = mkstemp(&pattern[0]);
+        if (fd < 0)
+        {
+            std::perror("mkstemp");
+            std::exit(1);
+        }
+        close(fd);
+        path = pattern;
+    }
+
+    ~TemporaryFile() { std::remove(path.c_str()); }
+
+    TemporaryFile(const TemporaryFile &) = delete;
+    TemporaryFile &operator=(const TemporaryFile &) = delete;
+
+    /**
+     * Returns the path of the file.
+     */
+    const std::string &name() const { return path; }
+
+private:
+    std::string path; // Path of the file
+};
+
+#endif // TEXTANALYSISTEST_H
@@ -0,0 +1,337 @@
+// TextAnalysisTokenizerTest.cpp
+//
+// Differential test of the tokenizer: every classification kernel, fed whole buffers, random chunks and memory-mapped
+// files, and the line-based '--ingest getline' reader must produce exactly the words of the original splitter on
+// seeded random input full of edge cases (NUL and high bytes, CR, hyphens, apostrophes, mixed case, long words),
+// including words that straddle the boundary between two mapping windows.
+
+#include "TextAnalysisTest.h"
+#include "TextAnalysisTokenizer.h"
+#include <algorithm>
+#include <cctype>
+#include <cstdint>
+#include <fcntl.h>
+#include <fstream>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+// Bytes mapped at a time by tokenizeFile (mappingWindow in TextAnalysisImplTokenizer.cpp)
+static const std::size_t mappingWindow = 64 * 1024 * 1024;
+
+// Token sink keeping a copy of every word
+class CollectingSink : public TokenSink
+{
+public:
+    std::vector<std::string> words; // Every word received, in order
+
+    void consumeToken(std::string_view word) override { words.emplace_back(word); }
+};
+
+/**
+ * The splitter of the original program, kept verbatim as the reference: each line (as std::getline cuts them) is
+ * scanned one character at a time. Only the std::isalnum argument is cast to unsigned char, which gives the same
+ * answers in the "C" locale without undefined behaviour for bytes above 0x7F.
+ *
+ * @param text The whole input.
+ * @param words Receives every word, in order.
+ */
+static void referenceSplit(const std::string &text, std::vector<std::string> &words)
+{
+    std::istringstream input(text);
+    std::string line;
+    while (std::getline(input, line))
+    {
+        std::string currentWord;
+        bool isWord = false;
+        for (char c : line)
+        {
+            if (std::isalnum(static_cast<unsigned char>(c)) || c == '-')
+            {
+                currentWord += static_cast<char>(std::tolower(static_cast<unsigned char>(c)));
+                isWord = true;
+            }
+            else if (isWord)
+            {
+                if (currentWord.length() > 2 && currentWord.substr(currentWord.length() - 2) == "'s")
+                {
+                    currentWord = currentWord.substr(0, currentWord.length() - 2);
+                }
+                words.push_back(currentWord);
+                currentWord = "";
+                isWord = false;
+            }
+        }
+        if (isWord)
+        {
+            words.push_back(currentWord);
+        }
+    }
+}
+
+/**
+ * Generates a random input made of fragments chosen to hit the tokenizer's edge cases.
+ * @param random The generator.
+ * @param length The approximate length of the input.
+ * @return The input.
+ */
+static std::string randomText(std::mt19937_64 &random, std::size_t length)
+{
+    static const char *const fragments[] = {"'s", "'S", "s'", "'", "-", "--", "-a-", "\r\n", "\r", "\n", " ", "  ",
+                                            "\t", ".", ",", "\xC3\x89t\xC3\xA9", "\xFF", "\x80", "ABC's", "x's "};
+    const std::size_t fragmentCount = sizeof(fragments) / sizeof(fragments[0]);
+    static const char wordBytes[] = "abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ0123456789-";
+
+    std::string text;
+    while (text.size() < length)
+    {
+        switch (random() % 8)
+        {
+        case 0:
+        case 1:
+        case 2:
+            text += fragments[random() % fragmentCount];
+            break;
+        case 3:
+            text += static_cast<char>(random() % 256); // Any byte, NUL included
+            break;
+        case 4:
+        {
+            // A long word, spanning several 64-byte groups and sometimes a 4096-byte stretch
+            std::size_t wordLength = 60 + random() % (random() % 4 == 0 ? 6000 : 200);
+            for (std::size_t i = 0; i < wordLength; i++)
+            {
+                text += wordBytes[random() % (sizeof(wordBytes) - 1)];
+            }
+            break;
+        }
+        default:
+        {
+            std::size_t wordLength = 1 + random() % 12;
+            for (std::size_t i = 0; i < wordLength; i++)
+            {
+                text += wordBytes[random() % (sizeof(wordBytes) - 1)];
+            }
+            break;
+        }
+        }
+    }
+    if (random() % 4 == 0)
+    {
+        text += '\0'; // Inputs ending on a NUL byte, with no final newline
+    }
+    return text;
+}
+
+// Makes a word printable in a failure message
+static std::string printable(const std::string &word)
+{
+    std::string shown;
+    for (unsigned char c : word.substr(0, 60))
+    {
+        if (c >= 0x20 && c < 0x7F)
+        {
+            shown += static_cast<char>(c);
+        }
+        else
+        {
+            char escape[8];
+            std::snprintf(escape, sizeof(escape), "\\x%02X", c);
+            shown += escape;
+        }
+    }
+    return word.size() > 60 ? shown + "..." : shown;
+}
+
+/**
+ * Checks that a run produced the reference words, describing the first difference otherwise.
+ * @param expected The words of the reference splitter.
+ * @param actual The words of the run under test.
+ * @param what A description of the run, for the failure message.
+ */
+static void checkWords(const std::vector<std::string> &expected, const std::vector<std::string> &actual,
+                       const std::string &what)
+{
+    if (expected == actual)
+    {
+        return;
+    }
+    std::size_t i = 0;
+    while (i < expected.size() && i < actual.size() && expected[i] == actual[i])
+    {
+        i++;
+    }
+    std::cerr << what << ": " << actual.size() << " words instead of " << expected.size() << ", first difference at "
+              << i << ": '" << (i < actual.size() ? printable(actual[i]) : "<end>") << "' instead of '"
+              << (i < expected.size() ? printable(expected[i]) : "<end>") << "'" << std::endl;
+    TEXTANALYSIS_CHECK(expected == actual);
+}
+
+// Writes a buffer to a file, replacing its content
+static void writeFile(const std::string &fileName, const std::string &content)
+{
+    std::ofstream out(fileName, std::ios::binary | std::ios::trunc);
+    out.write(content.data(), static_cast<std::streamsize>(content.size()));
+}
+
+// Returns the kernels available on this CPU
+static std::vector<TokenizerKernel> availableKernels()
+{
+    std::vector<TokenizerKernel> kernels;
+    for (TokenizerKernel kernel : {TokenizerKernel::Scalar, TokenizerKernel::SSE2, TokenizerKernel::AVX2})
+    {
+        if (selectTokenizerKernel(kernel))
+        {
+            kernels.push_back(kernel);
+        }
+        else
+        {
+            std::cout << "Kernel " << tokenizerKernelName(kernel) << " is not available, skipped" << std::endl;
+        }
+    }
+    return kernels;
+}
+
+/**
+ * Compares every way of tokenizing one input with the reference splitter.
+ * @param text The input.
+ * @param kernels The kernels to try.
+ * @param random The generator choosing chunk sizes.
+ * @param what A description of the input, for failure messages.
+ */
+static void checkInput(const std::string &text, const std::vector<TokenizerKernel> &kernels,
+                       std::mt19937_64 &random, const std::string &what)
+{
+    std::vector<std::string> expected;
+    referenceSplit(text, expected);
+
+    TemporaryFile file("TextAnalysisTokenizerTest");
+    writeFile(file.name(), text);
+
+    for (TokenizerKernel kernel : kernels)
+    {
+        selectTokenizerKernel(kernel);
+        std::string name = what + " [" + tokenizerKernelName(kernel) + "]";
+
+        // The whole input in one chunk
+        CollectingSink whole;
+        Tokenizer wholeTokenizer(whole);
+        wholeTokenizer.feed(text.data(), text.size());
+        wholeTokenizer.finish();
+        checkWords(expected, whole.words, name + " whole buffer");
+
+        // Random chunks, from empty ones to several stretches, so that words continue across feeds
+        CollectingSink chunked;
+        Tokenizer chunkTokenizer(chunked);
+        for (std::size_t position = 0; position < text.size();)
+        {
+            std::size_t chunk = random() % 3 == 0 ? random() % 8 : random() % 9000;
+            chunk = std::min(chunk, text.size() - position);
+            chunkTokenizer.feed(text.data() + position, chunk);
+            position += chunk;
+        }
+        chunkTokenizer.finish();
+        checkWords(expected, chunked.words, name + " random chunks");
+
+        // The memory-mapped file, whole and split into word-aligned ranges as --split does
+        CollectingSink mapped;
+        TEXTANALYSIS_CHECK(tokenizeFile(file.name(), mapped));
+        checkWords(expected, mapped.words, name + " tokenizeFile");
+
+        std::vector<std::uint64_t> boundaries;
+        TEXTANALYSIS_CHECK(splitAtWordBoundaries(file.name(), 1 + random() % 4, boundaries));
+        CollectingSink ranges;
+        for (std::size_t part = 0; part + 1 < boundaries.size(); part++)
+        {
+            TEXTANALYSIS_CHECK(tokenizeFileRange(file.name(), boundaries[part], boundaries[part + 1], ranges));
+        }
+        checkWords(expected, ranges.words, name + " tokenizeFileRange");
+    }
+
+    // --ingest getline
+    CollectingSink lines;
+    TEXTANALYSIS_CHECK(tokenizeFileByLines(file.name(), lines));
+    checkWords(expected, lines.words, what + " tokenizeFileByLines");
+}
+
+/**
+ * Checks words placed around the boundary between the first two mapping windows of a sparse file whose other bytes
+ * are NULs (separators).
+ * @param kernels The kernels to try.
+ * @param random The generator.
+ */
+static void checkWindowBoundary(const std::vector<TokenizerKernel> &kernels, std::mt19937_64 &random)
+{
+    // A word straddling the boundary, a word ending right before it and a word starting right on it
+    struct Layout
+    {
+        const char *name;
+        std::size_t offset; // Where the word is written, relative to the window boundary
+    };
+    const std::string word = "MixedCase-Word-0123456789-acrossTheWindow";
+    const Layout layouts[] = {{"straddling", mappingWindow - word.size() / 2},
+                              {"ending at", mappingWindow - word.size()},
+                              {"starting at", mappingWindow}};
+
+    for (const Layout &layout : layouts)
+    {
+        TemporaryFile file("TextAnalysisTokenizerTest");
+        std::string around = randomText(random, 64 * 1024);
+        std::string before = around.substr(0, around.size() / 2);
+        std::string after = around.substr(around.size() / 2);
+
+        // The file is sparse: only the text around the boundary is written, the rest reads as NUL bytes
+        int fd = open(file.name().c_str(), O_WRONLY);
+        auto writeAt = [fd](const std::string &text, std::size_t offset)
+        {
+            ssize_t written = pwrite(fd, text.data(), text.size(), static_cast<off_t>(offset));
+            return written == static_cast<ssize_t>(text.size());
+        };
+        bool written = fd >= 0 && ftruncate(fd, static_cast<off_t>(mappingWindow + 1024 * 1024)) == 0 &&
+                       writeAt(before + " ", layout.offset - 1 - before.size()) && writeAt(word, layout.offset) &&
+                       writeAt("\r\n" + after, layout.offset + word.size());
+        if (fd >= 0)
+        {
+            close(fd);
+        }
+        TEXTANALYSIS_CHECK(written);
+
+        // NUL bytes only separate words, so the reference only needs the text that was written
+        std::vector<std::string> expected;
+        referenceSplit(before + " " + word + "\r\n" + after, expected);
+        std::string what = std::string("word ") + layout.name + " the window boundary";
+
+        for (TokenizerKernel kernel : kernels)
+        {
+            selectTokenizerKernel(kernel);
+            CollectingSink mapped;
+            TEXTANALYSIS_CHECK(tokenizeFile(file.name(), mapped));
+            checkWords(expected, mapped.words, what + " [" + tokenizerKernelName(kernel) + "] tokenizeFile");
+        }
+        CollectingSink lines;
+        TEXTANALYSIS_CHECK(tokenizeFileByLines(file.name(), lines));
+        checkWords(expected, lines.words, what + " tokenizeFileByLines");
+    }
+}
+
+int main()
+{
+    std::mt19937_64 random(20240611);
+    std::vector<TokenizerKernel> kernels = availableKernels();
+
+    // Short inputs exercise the group and stretch edges, longer ones the mapping and the read buffer
+    for (int round = 0; round < 300; round++)
+    {
+        std::size_t length = round < 200 ? random() % 300 : random() % 40000;
+        checkInput(randomText(random, length), kernels, random, "random input " + std::to_string(round));
+    }
+    checkInput("", kernels, random, "empty input");
+    checkInput(std::string(5000, '\0'), kernels, random, "only NUL bytes");
+    checkInput(std::string(10000, 'Q'), kernels, random, "one long uppercase word");
+
+    checkWindowBoundary(kernels, random);
+
+    selectTokenizerKernel(TokenizerKernel::Auto);
+    return testResult("TextAnalysisTokenizerTest");
+}